@@ -42,13 +42,13 @@ static void led_callback(Task* task) {
     // To change behavior:
     // task->callback = another_callback;
     // To change interval:
-    // task->interval = 2000;
+    // task->interval = ASYNC_MS(2000);
     led_t *d = (led_t *)task;
     d->state = !d->state;
     d->state ? led_on(d->pin):led_off(d->pin);
 }
 
-static void init_led(led_t* led, uint32_t pin, uint32_t interval, TaskCallback callbk)
+static void init_led(led_t* led, uint32_t pin, async_time_t interval, TaskCallback callbk)
 {
     led->task.callback = callbk;
     led->task.interval = interval;
@@ -78,24 +78,32 @@ int main()
 
     TaskList_Init(&ActiveTasksList);
 
-    led_t led1;
-    init_led(&led1, LED_1, 600, led_callback);
-    led_t led2;
-    init_led(&led2, LED_2, 250, led_callback);
+    led_t led1 = {0};
+    init_led(&led1, LED_1, ASYNC_MS(600), led_callback);
+    led_t led2 = {0};
+    init_led(&led2, LED_2, ASYNC_MS(250), led_callback);
 
-    print_task_t printSecs;
+    print_task_t printSecs = {0};
     printSecs.sec_counter = 0;
     printSecs.task.callback = printSecs_callback;
-    printSecs.task.interval = 1000;
+    printSecs.task.interval = ASYNC_MS(1000);
+
+#if ASYNC_TASK_COALESCE
+    // The LEDs and the print may run a little late to share wakes
+    led1.task.slack = ASYNC_MS(100);
+    led2.task.slack = ASYNC_MS(50);
+    printSecs.task.slack = ASYNC_MS(200);
+#endif
+#if ASYNC_TASK_GOVERNOR
+    // Printing gives way when the loop falls behind; the LEDs keep blinking
+    printSecs.task.shed = SHED_STRETCH;
+#endif
 
     TaskList_Add(&ActiveTasksList, (Task *)&led1);
     TaskList_Add(&ActiveTasksList, (Task *)&led2);
     TaskList_Add(&ActiveTasksList, (Task *)&printSecs);
 
-    while (true) {
-        Update(&ActiveTasksList);
-        sleep_ms(5);
-
-    }
+    // Sleeps until the next task is due instead of polling every few ms
+    scheduler_run(&ActiveTasksList);
 
 }
@@ -0,0 +1,46 @@
+// Same LEDs and seconds counter as async_tasks_example.c, declared as a
+// compile-time task table (../pico_async/async_static.hpp)
+#include <cstdio>
+#include "pico/stdlib.h"
+#include "async_static.hpp"
+
+#define LED_1   (7)
+#define LED_2   (8)
+
+struct led_t {
+    uint pin;
+    bool state;
+};
+
+struct print_secs_t {
+    uint32_t sec_counter;
+};
+
+static void led_callback(led_t& led) {
+    led.state = !led.state;
+    gpio_put(led.pin, led.state);
+}
+
+static void printSecs_callback(print_secs_t& ps) {
+    ps.sec_counter++;
+    printf("Passed=%lu secs.\n", (unsigned long)ps.sec_counter);
+}
+
+// Constant-initialized: nothing to register at startup
+static async::task_table tasks{
+    async::periodic_task<led_t, led_callback, ASYNC_MS(600)>{{LED_1, false}},
+    async::periodic_task<led_t, led_callback, ASYNC_MS(250)>{{LED_2, false}},
+    async::periodic_task<print_secs_t, printSecs_callback, ASYNC_MS(1000)>{{0}},
+};
+
+int main()
+{
+    stdio_init_all();
+    for (uint pin : {tasks.context<0>().pin, tasks.context<1>().pin}) {
+        gpio_init(pin);
+        gpio_set_dir(pin, GPIO_OUT);
+    }
+
+    // Sleeps until the next task is due, like scheduler_run()
+    tasks.run();
+}
@@ -0,0 +1,130 @@
+// Host benchmark of the dual-core scheduler: two pthreads stand in for the
+// RP2350 cores. Measures dispatch throughput per core with pinned tasks, then
+// with every task migrating to the other core every few runs, which loads the
+// lock-free handoff queues from both sides.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "async_multicore.h"
+
+#define NUM_TASKS       (64u)
+#define RUN_SECONDS     (1u)
+#define WORK_LOOPS      (200u)  // simulated callback work
+#define MIGRATE_EVERY   (4u)    // runs between migrations in the second phase
+
+typedef struct {
+    Task task;
+    uint32_t runs;
+} bench_task_t;
+
+static _Thread_local uint32_t this_core = 0;
+static atomic_bool stop;
+static atomic_bool core1_ready;
+static bool migrate;
+static bench_task_t tasks[NUM_TASKS];
+
+uint32_t async_core_num(void)
+{
+    return this_core;
+}
+
+async_time_t async_time_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (async_time_t)ts.tv_sec * 1000000u + (async_time_t)(ts.tv_nsec / 1000);
+}
+
+void scheduler_sleep_until(async_time_t deadline)
+{
+    async_time_t now = async_time_now();
+    if (deadline == SCHEDULER_NO_DEADLINE || deadline <= now) {
+        return;
+    }
+    struct timespec ts = {0, (long)(deadline - now) * 1000};
+    nanosleep(&ts, NULL);
+}
+
+static void work_callback(Task* task)
+{
+    bench_task_t* bt = (bench_task_t*)task;
+    volatile uint32_t sink = 0;
+    for (uint32_t i = 0; i < WORK_LOOPS; i++) {
+        sink += i;
+    }
+    bt->runs++;
+    if (migrate && bt->runs % MIGRATE_EVERY == 0) {
+        Multicore_Migrate(task, 1u - async_core_num());
+    }
+}
+
+static void* core1_entry(void* arg)
+{
+    (void)arg;
+    this_core = 1;
+    // Each core adds its own half, so the handoff queue only carries migrations
+    for (uint32_t i = 1; i < NUM_TASKS; i += ASYNC_CORES) {
+        Multicore_Add(&tasks[i].task, 1);
+    }
+    atomic_store(&core1_ready, true);
+    while (!atomic_load(&stop)) {
+        Multicore_Update();
+    }
+    return NULL;
+}
+
+static void run_phase(const char* name, bool with_migration)
+{
+    Multicore_Init();
+    migrate = with_migration;
+    atomic_store(&stop, false);
+    atomic_store(&core1_ready, false);
+    for (uint32_t i = 0; i < NUM_TASKS; i++) {
+        tasks[i] = (bench_task_t){0};
+        tasks[i].task.callback = work_callback;
+        tasks[i].task.interval = 0;
+        tasks[i].task.pinned = !with_migration;
+        if (i % ASYNC_CORES == 0) {
+            Multicore_Add(&tasks[i].task, 0);
+        }
+    }
+
+    pthread_t core1;
+    pthread_create(&core1, NULL, core1_entry, NULL);
+    while (!atomic_load(&core1_ready)) {
+    }
+    async_time_t end = async_time_now() + ASYNC_SEC(RUN_SECONDS);
+    while (async_time_now() < end) {
+        Multicore_Update();
+    }
+    atomic_store(&stop, true);
+    pthread_join(core1, NULL);
+
+    printf("%s:\n", name);
+    printf("  core %10s %10s %8s %8s %8s %7s\n", "passes", "dispatched", "mig_in", "mig_out", "full", "busy%");
+    uint32_t total = 0;
+    for (uint32_t c = 0; c < ASYNC_CORES; c++) {
+        const CoreLoad* l = Multicore_Load(c);
+        printf("  %4u %10u %10u %8u %8u %8u %6.1f%%\n", c, l->passes, l->dispatched, l->migrated_in,
+               l->migrated_out, l->handoff_full, 100.0 * (double)l->busy_us / ASYNC_SEC(RUN_SECONDS));
+        total += l->dispatched;
+    }
+    printf("  throughput: %.0f dispatches/s\n", (double)total / RUN_SECONDS);
+}
+
+int main(void)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("mode: %s, %u tasks, %ld host cpu(s)\n", ASYNC_TASK_USE_HEAP ? "heap" : "list", NUM_TASKS, cpus);
+    if (cpus < ASYNC_CORES) {
+        // The threads take turns instead of running in parallel, so each
+        // handoff queue stays full while its consumer is descheduled
+        printf("  warning: fewer host cpus than cores, migration numbers are not meaningful\n");
+    }
+    run_phase("pinned", false);
+    run_phase("migrating", true);
+    return 0;
+}
@@ -0,0 +1,115 @@
+// Host benchmark: the compile-time task table (async_static.hpp) against
+// Update() on the same task mix, on a virtual clock with one pass per
+// simulated ms like bench_update.c.
+#include <cstdio>
+#include <ctime>
+#include "async_task.h"
+#include "async_static.hpp"
+
+#define SIM_MS      (2000000u)  // simulated run time
+
+static async_time_t now_us = 0;
+
+// Virtual clock used by async_task.c and async_static.hpp in host builds
+extern "C" async_time_t async_time_now(void)
+{
+    return now_us;
+}
+
+// Not used here: the benchmark runs one pass per simulated ms
+extern "C" void scheduler_sleep_until(async_time_t deadline)
+{
+    (void)deadline;
+}
+
+struct counter_t {
+    uint32_t runs;
+};
+
+static void count_static(counter_t& c)
+{
+    c.runs++;
+}
+
+struct counter_task_t {
+    Task task;
+    uint32_t runs;
+};
+
+static void count_callback(Task* task)
+{
+    ((counter_task_t*)task)->runs++;
+}
+
+// Eight tasks, 1..500 ms
+static const async_time_t intervals[] = {
+    ASYNC_MS(1), ASYNC_MS(2), ASYNC_MS(5), ASYNC_MS(10),
+    ASYNC_MS(50), ASYNC_MS(100), ASYNC_MS(250), ASYNC_MS(500),
+};
+#define N_TASKS (sizeof(intervals) / sizeof(intervals[0]))
+
+static async::task_table static_tasks{
+    async::periodic_task<counter_t, count_static, ASYNC_MS(1)>{{0}},
+    async::periodic_task<counter_t, count_static, ASYNC_MS(2)>{{0}},
+    async::periodic_task<counter_t, count_static, ASYNC_MS(5)>{{0}},
+    async::periodic_task<counter_t, count_static, ASYNC_MS(10)>{{0}},
+    async::periodic_task<counter_t, count_static, ASYNC_MS(50)>{{0}},
+    async::periodic_task<counter_t, count_static, ASYNC_MS(100)>{{0}},
+    async::periodic_task<counter_t, count_static, ASYNC_MS(250)>{{0}},
+    async::periodic_task<counter_t, count_static, ASYNC_MS(500)>{{0}},
+};
+
+static double elapsed_ns(const struct timespec* a, const struct timespec* b)
+{
+    return (double)(b->tv_sec - a->tv_sec) * 1e9 + (double)(b->tv_nsec - a->tv_nsec);
+}
+
+static void report(const char* name, uint32_t fired, double ns)
+{
+    printf("%-14s %10u %12.1f %14.1f\n", name, fired, ns / SIM_MS, fired ? ns / fired : 0.0);
+}
+
+int main(void)
+{
+    printf("%zu tasks, %u simulated ms, TaskList mode: %s\n", N_TASKS, SIM_MS,
+           ASYNC_TASK_USE_HEAP ? "heap" : "list");
+    printf("%-14s %10s %12s %14s\n", "scheduler", "fired", "ns/pass", "ns/dispatch");
+
+    struct timespec t0, t1;
+
+    static counter_task_t tasks[N_TASKS];
+    TaskList list;
+    TaskList_Init(&list);
+    now_us = 0;
+    for (size_t i = 0; i < N_TASKS; i++) {
+        tasks[i].task.callback = count_callback;
+        tasks[i].task.interval = intervals[i];
+        TaskList_Add(&list, &tasks[i].task);
+    }
+    uint32_t fired = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (uint32_t ms = 1; ms <= SIM_MS; ms++) {
+        now_us = ASYNC_MS(ms);
+        fired += Update(&list);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    report("TaskList", fired, elapsed_ns(&t0, &t1));
+
+    fired = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (uint32_t ms = 1; ms <= SIM_MS; ms++) {
+        now_us = ASYNC_MS(ms);
+        fired += static_tasks.update();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    report("task_table", fired, elapsed_ns(&t0, &t1));
+
+    // Both must have run every task the same number of times
+    uint32_t expected = 0;
+    for (size_t i = 0; i < N_TASKS; i++) {
+        expected += (uint32_t)(ASYNC_MS(SIM_MS) / intervals[i]);
+    }
+    bool ok = fired == expected && static_tasks.context<7>().runs == tasks[7].runs;
+    printf("%s (expected %u runs)\n", ok ? "ok" : "MISMATCH", expected);
+    return ok ? 0 : 1;
+}
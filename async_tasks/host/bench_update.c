@@ -0,0 +1,95 @@
+// Host benchmark: cost of Update() as the number of tasks grows.
+// Runs against a virtual clock, one Update() per simulated ms,
+// the way the Pico main loop calls it, then times TaskList_Remove() +
+// TaskList_Add() of random tasks (task churn).
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "async_task.h"
+
+#define SIM_MS      (10000u)    // simulated run time per task count
+#define MIN_N       (4u)
+#define MAX_N       (4096u)
+#define CHURN       (100000u)   // remove + add pairs per task count
+
+static async_time_t now_us = 0;
+static uint32_t fired = 0;
+
+// Virtual clock used by async_task.c in host builds
+async_time_t async_time_now(void)
+{
+    return now_us;
+}
+
+// Not used here: the benchmark calls Update() once per simulated ms
+void scheduler_sleep_until(async_time_t deadline)
+{
+    (void)deadline;
+}
+
+static void count_callback(Task* task)
+{
+    (void)task;
+    fired++;
+}
+
+// Small deterministic generator so every mode sees the same task mix
+static uint32_t rng_state = 12345u;
+static uint32_t rng_next(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static double elapsed_ns(const struct timespec* a, const struct timespec* b)
+{
+    return (double)(b->tv_sec - a->tv_sec) * 1e9 + (double)(b->tv_nsec - a->tv_nsec);
+}
+
+int main(void)
+{
+    printf("mode: %s\n", ASYNC_TASK_USE_HEAP ? "heap" : "list");
+    printf("%6s %10s %14s %16s %16s\n", "tasks", "fired", "ns/Update", "ns/dispatch", "ns/remove+add");
+
+    for (uint32_t n = MIN_N; n <= MAX_N; n *= 2) {
+        Task* tasks = calloc(n, sizeof(Task));
+        if (tasks == NULL) {
+            return 1;
+        }
+
+        TaskList list;
+        TaskList_Init(&list);
+        rng_state = 12345u;
+        now_us = 0;
+        fired = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            tasks[i].callback = count_callback;
+            tasks[i].interval = ASYNC_MS(10 + rng_next() % 990); // 10..999 ms
+            TaskList_Add(&list, &tasks[i]);
+        }
+
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (uint32_t ms = 1; ms <= SIM_MS; ms++) {
+            now_us = ASYNC_MS(ms);
+            Update(&list);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        double ns = elapsed_ns(&t0, &t1);
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (uint32_t i = 0; i < CHURN; i++) {
+            Task* task = &tasks[rng_next() % n];
+            TaskList_Remove(&list, task);
+            TaskList_Add(&list, task);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double churn_ns = elapsed_ns(&t0, &t1);
+
+        printf("%6u %10u %14.1f %16.1f %16.1f\n", n, fired, ns / SIM_MS, fired ? ns / fired : 0.0,
+               churn_ns / CHURN);
+        free(tasks);
+    }
+    return 0;
+}
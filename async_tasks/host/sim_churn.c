@@ -0,0 +1,183 @@
+// Host check of adding and removing tasks from inside callbacks.
+// Callbacks of a pool of tasks on a virtual clock randomly remove themselves,
+// remove another task, add a task back, or remove and re-add themselves,
+// while a shadow model tracks which tasks are listed. Every pass checks that:
+//  - only listed tasks run, and none runs twice in one pass
+//  - a task added during a pass does not run in that pass
+//  - every listed task that was due when the pass started and was not
+//    removed meanwhile has run
+//  - the list links are consistent and hold exactly the listed tasks
+#include <stdio.h>
+#include <string.h>
+#include "async_task.h"
+
+#define NUM_TASKS   (64)
+#define SIM_MS      (200000u)
+
+static async_time_t now_us = 0;
+static TaskList list;
+static Task tasks[NUM_TASKS];
+
+// Shadow model
+static bool listed[NUM_TASKS];
+static bool added_in_pass[NUM_TASKS];
+static bool removed_in_pass[NUM_TASKS];
+static bool due_at_start[NUM_TASKS];
+static uint32_t runs_in_pass[NUM_TASKS];
+static uint32_t errors = 0;
+static uint32_t churn = 0;
+
+// Virtual clock used by async_task.c in host builds
+async_time_t async_time_now(void)
+{
+    return now_us;
+}
+
+// Not used here: the check calls Update() once per simulated ms
+void scheduler_sleep_until(async_time_t deadline)
+{
+    (void)deadline;
+}
+
+// Small deterministic generator so every mode sees the same churn
+static uint32_t rng_state = 12345u;
+static uint32_t rng_next(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static void fail(const char* what, uint32_t index)
+{
+    if (errors++ < 10) {
+        printf("FAIL at %llu us: task %u %s\n", (unsigned long long)now_us, index, what);
+    }
+}
+
+static void add(uint32_t i)
+{
+    if (!listed[i]) {
+        listed[i] = true;
+        added_in_pass[i] = true;
+        removed_in_pass[i] = false;
+    }
+    TaskList_Add(&list, &tasks[i]);
+}
+
+static void remove_task(uint32_t i)
+{
+    if (listed[i]) {
+        listed[i] = false;
+        removed_in_pass[i] = true;
+    }
+    TaskList_Remove(&list, &tasks[i]);
+}
+
+static void churn_callback(Task* task)
+{
+    uint32_t self = (uint32_t)(task - tasks);
+    if (!listed[self]) {
+        fail("ran while not listed", self);
+    }
+    if (added_in_pass[self]) {
+        fail("ran in the pass that added it", self);
+    }
+    if (++runs_in_pass[self] > 1) {
+        fail("ran twice in one pass", self);
+    }
+
+    uint32_t other = rng_next() % NUM_TASKS;
+    switch (rng_next() % 8) {
+    case 0:
+        remove_task(self);
+        churn++;
+        break;
+    case 1:
+        remove_task(other);
+        churn++;
+        break;
+    case 2:
+    case 3:
+        add(other);
+        churn++;
+        break;
+    case 4:
+        remove_task(self);
+        add(self);
+        churn += 2;
+        break;
+    default:
+        break;
+    }
+}
+
+static void check_links(void)
+{
+    uint32_t count = 0;
+    Task* prev = NULL;
+#if ASYNC_TASK_USE_HEAP
+    (void)prev;
+    for (uint32_t i = 0; i < NUM_TASKS; i++) {
+        bool in_heap = &tasks[i] == list.head || tasks[i].prev != NULL;
+        if (in_heap != listed[i]) {
+            fail(in_heap ? "in the heap but not listed" : "listed but not in the heap", i);
+        }
+        count += in_heap;
+    }
+#else
+    for (Task* t = list.head; t != NULL; t = t->next) {
+        uint32_t i = (uint32_t)(t - tasks);
+        if (t->prev != prev) {
+            fail("has a broken prev link", i);
+        }
+        if (!listed[i] || !t->listed) {
+            fail("in the list but not listed", i);
+        }
+        prev = t;
+        if (++count > NUM_TASKS) {
+            fail("list has a cycle", i);
+            return;
+        }
+    }
+#endif
+    uint32_t expected = 0;
+    for (uint32_t i = 0; i < NUM_TASKS; i++) {
+        expected += listed[i];
+    }
+    if (count != expected) {
+        fail("count differs from the model", count);
+    }
+}
+
+int main(void)
+{
+    TaskList_Init(&list);
+    for (uint32_t i = 0; i < NUM_TASKS; i++) {
+        tasks[i].callback = churn_callback;
+        tasks[i].interval = ASYNC_MS(1 + rng_next() % 20);
+        add(i);
+    }
+
+    uint32_t ran = 0;
+    for (uint32_t ms = 1; ms <= SIM_MS; ms++) {
+        now_us = ASYNC_MS(ms);
+        for (uint32_t i = 0; i < NUM_TASKS; i++) {
+            due_at_start[i] = listed[i] && async_time_reached(now_us, tasks[i].next_run_at);
+        }
+        memset(added_in_pass, 0, sizeof(added_in_pass));
+        memset(removed_in_pass, 0, sizeof(removed_in_pass));
+        memset(runs_in_pass, 0, sizeof(runs_in_pass));
+        ran += Update(&list);
+        for (uint32_t i = 0; i < NUM_TASKS; i++) {
+            // Removed and re-added tasks may legitimately be skipped
+            if (due_at_start[i] && runs_in_pass[i] == 0 && !removed_in_pass[i] && !added_in_pass[i]) {
+                fail("was due but did not run", i);
+            }
+        }
+        check_links();
+    }
+
+    printf("mode: %s, %u ms, %u runs, %u adds/removes from callbacks, %u errors\n",
+           ASYNC_TASK_USE_HEAP ? "heap" : "list", SIM_MS, ran, churn, errors);
+    return errors != 0;
+}
@@ -0,0 +1,111 @@
+// Host check of wakeup coalescing on a virtual clock.
+// Runs the example task mix (600, 250 and 1000 ms) plus a few sensor-style
+// tasks on unrelated periods through Update() + scheduler_idle(), once with
+// exact deadlines and once with each task allowed a quarter period of slack.
+// No task may run before next_run_at or more than its slack after it, and the
+// coalesced run must need fewer wakes for the same firings.
+#include <stdio.h>
+#include "async_task.h"
+
+#define SIM_MS      (600000u)   // ten simulated minutes
+#define NUM_TASKS   (6)
+
+static const uint32_t intervals[NUM_TASKS] = {600, 250, 1000, 130, 170, 410};
+
+static async_time_t now_us = 0;
+static uint32_t firings = 0;
+static uint32_t early = 0;
+static uint32_t late = 0;           // started after next_run_at + slack
+static async_time_t late_max_us = 0;
+
+// Virtual clock used by async_task.c in host builds
+async_time_t async_time_now(void)
+{
+    return now_us;
+}
+
+// Sleeping jumps the clock straight to the deadline
+void scheduler_sleep_until(async_time_t deadline)
+{
+    if (deadline == SCHEDULER_NO_DEADLINE) {
+        deadline = now_us + ASYNC_MS(SIM_MS);
+    }
+    now_us = deadline;
+}
+
+// next_run_at is still the due time while the callback runs
+static void check_callback(Task* task)
+{
+    firings++;
+    if (async_time_before(now_us, task->next_run_at)) {
+        early++;
+        return;
+    }
+    async_time_t lateness = now_us - task->next_run_at;
+    if (lateness > task->slack) {
+        late++;
+    }
+    if (lateness > late_max_us) {
+        late_max_us = lateness;
+    }
+}
+
+typedef struct {
+    uint32_t wakes;
+    uint32_t wakes_saved;
+    uint32_t firings;
+} sim_result_t;
+
+static sim_result_t simulate(uint32_t slack_div)
+{
+    static Task tasks[NUM_TASKS];
+    TaskList list;
+
+    now_us = 0;
+    firings = 0;
+    TaskList_Init(&list);
+    for (int i = 0; i < NUM_TASKS; i++) {
+        tasks[i] = (Task){0};
+        tasks[i].callback = check_callback;
+        tasks[i].interval = ASYNC_MS(intervals[i]);
+        tasks[i].slack = slack_div ? tasks[i].interval / slack_div : 0;
+        TaskList_Add(&list, &tasks[i]);
+    }
+    while (now_us < ASYNC_MS(SIM_MS)) {
+        Update(&list);
+        scheduler_idle(&list);
+    }
+    return (sim_result_t){list.wakes, list.wakes_saved, firings};
+}
+
+int main(void)
+{
+    sim_result_t exact = simulate(0);
+    sim_result_t coalesced = simulate(4);
+
+    printf("mode: %s, simulated %u ms, %d tasks\n", ASYNC_TASK_USE_HEAP ? "heap" : "list", SIM_MS, NUM_TASKS);
+    printf("exact:     %6u wakes, %6u firings\n", exact.wakes, exact.firings);
+    printf("slack T/4: %6u wakes, %6u firings, %u wakes saved, late max %llu us\n", coalesced.wakes,
+           coalesced.firings, coalesced.wakes_saved, (unsigned long long)late_max_us);
+
+    int fail = 0;
+    if (early != 0 || late != 0) {
+        printf("FAIL: %u early and %u late starts\n", early, late);
+        fail = 1;
+    }
+    if (exact.wakes_saved != 0) {
+        printf("FAIL: exact run saved %u wakes\n", exact.wakes_saved);
+        fail = 1;
+    }
+    // Slack only delays a run, so the coalesced run may lose at most one
+    // firing per task at the end of the window
+    if (coalesced.firings + NUM_TASKS < exact.firings) {
+        printf("FAIL: coalesced run dropped firings\n");
+        fail = 1;
+    }
+    if (coalesced.wakes >= exact.wakes) {
+        printf("FAIL: slack saved no wakes\n");
+        fail = 1;
+    }
+    return fail;
+}
@@ -0,0 +1,107 @@
+// Host check of the overload governor on a virtual clock.
+// A 10 ms sensor and a 20 ms control task (critical) share the loop with a
+// diagnostics task (SHED_SKIP) and a UART print task (SHED_STRETCH). From 10 s
+// to 20 s the I2C bus and the UART back up: every callback gets slower and
+// the loop needs more than 100% of the CPU. Built with ASYNC_TASK_GOVERNOR=0
+// the critical tasks miss periods for the whole stall; with the governor the
+// sheddable tasks give way and the critical tasks keep their cadence once the
+// lag has been detected.
+#include <stdio.h>
+#include "async_task.h"
+
+#define SIM_MS      (30000u)
+#define STALL_FROM  ASYNC_MS(10000)
+#define STALL_TO    ASYNC_MS(20000)
+
+typedef struct {
+    Task task;
+    const char* name;
+    async_time_t cost_us;       // callback duration, normal and during the stall
+    async_time_t stall_cost_us;
+    bool critical;
+    uint32_t runs;
+    async_time_t late_max_us;
+} sim_task_t;
+
+static async_time_t now_us = 0;
+
+// Virtual clock used by async_task.c in host builds
+async_time_t async_time_now(void)
+{
+    return now_us;
+}
+
+// Sleeping jumps the clock straight to the deadline
+void scheduler_sleep_until(async_time_t deadline)
+{
+    if (deadline == SCHEDULER_NO_DEADLINE) {
+        deadline = now_us + ASYNC_MS(SIM_MS);
+    }
+    now_us = deadline;
+}
+
+// A callback takes its time by moving the clock
+static void sim_callback(Task* task)
+{
+    sim_task_t* t = (sim_task_t*)task;
+    async_time_t late = now_us - task->next_run_at;
+    bool stalled = !async_time_before(now_us, STALL_FROM) && async_time_before(now_us, STALL_TO);
+    t->runs++;
+    if (late > t->late_max_us) {
+        t->late_max_us = late;
+    }
+    now_us += stalled ? t->stall_cost_us : t->cost_us;
+}
+
+int main(void)
+{
+    static sim_task_t tasks[] = {
+        {.name = "print",   .task.interval = ASYNC_MS(40), .cost_us = 1000, .stall_cost_us = 9000},
+        {.name = "diag",    .task.interval = ASYNC_MS(25), .cost_us = 1000, .stall_cost_us = 7000},
+        {.name = "control", .task.interval = ASYNC_MS(20), .cost_us = 500,  .stall_cost_us = 2000, .critical = true},
+        {.name = "sensor",  .task.interval = ASYNC_MS(10), .cost_us = 500,  .stall_cost_us = 3000, .critical = true},
+    };
+    const int count = sizeof(tasks) / sizeof(tasks[0]);
+
+    TaskList list;
+    TaskList_Init(&list);
+    for (int i = 0; i < count; i++) {
+        tasks[i].task.callback = sim_callback;
+#if ASYNC_TASK_GOVERNOR
+        tasks[i].task.shed = tasks[i].critical ? SHED_NEVER : i == 0 ? SHED_STRETCH : SHED_SKIP;
+#endif
+        TaskList_Add(&list, &tasks[i].task);
+    }
+    while (now_us < ASYNC_MS(SIM_MS)) {
+        Update(&list);
+        scheduler_idle(&list);
+    }
+
+    printf("mode: %s, governor %s, simulated %u ms, stall %llu..%llu ms\n", ASYNC_TASK_USE_HEAP ? "heap" : "list",
+           ASYNC_TASK_GOVERNOR ? "on" : "off", SIM_MS, (unsigned long long)(STALL_FROM / 1000),
+           (unsigned long long)(STALL_TO / 1000));
+    printf("task       runs  missed  late max (us)\n");
+    uint32_t critical_missed = 0;
+    for (int i = 0; i < count; i++) {
+        printf("%-8s %6u %7u %10llu\n", tasks[i].name, tasks[i].runs, tasks[i].task.missed,
+               (unsigned long long)tasks[i].late_max_us);
+        if (tasks[i].critical) {
+            critical_missed += tasks[i].task.missed;
+        }
+    }
+#if ASYNC_TASK_GOVERNOR
+    const TaskGovernor* gov = &list.governor;
+    printf("governor: %u engages, %u releases, %u stretched, %u skipped, lag max %llu us, %s\n", gov->engages,
+           gov->releases, gov->stretched, gov->skipped, (unsigned long long)gov->lag_max_us,
+           gov->engaged ? "engaged" : "released");
+    // The lag has to build up before the governor reacts: allow one missed
+    // critical period per overload episode
+    if (gov->engages == 0 || gov->engaged || critical_missed > gov->engages) {
+        printf("FAIL: the governor did not protect the critical tasks\n");
+        return 1;
+    }
+#else
+    (void)critical_missed;
+#endif
+    return 0;
+}
@@ -0,0 +1,84 @@
+// Host check of the tickless idle loop on a virtual clock.
+// Runs the example task mix (600, 250 and 1000 ms) through Update() +
+// scheduler_idle() and counts how often the loop wakes up. Every wake must
+// coincide with at least one task firing; the old loop spun every 5 ms.
+// Two stopped tasks (callback cleared after TaskList_Add(), interval 0 and
+// 100 ms) stay on the list and must not wake the loop.
+#include <stdio.h>
+#include "async_task.h"
+
+#define SIM_MS      (60000u)    // one simulated minute
+#define POLL_MS     (5u)        // sleep_ms() of the old busy-poll loop
+
+static async_time_t now_us = 0;
+static uint32_t wakes = 0;
+static uint32_t firings = 0;
+static uint32_t fire_instants = 0;  // distinct times at which something fired
+static async_time_t last_fire_us = SCHEDULER_NO_DEADLINE;
+
+// Virtual clock used by async_task.c in host builds
+async_time_t async_time_now(void)
+{
+    return now_us;
+}
+
+// Sleeping jumps the clock straight to the deadline
+void scheduler_sleep_until(async_time_t deadline)
+{
+    if (deadline == SCHEDULER_NO_DEADLINE) {
+        deadline = now_us + ASYNC_MS(SIM_MS);
+    }
+    now_us = deadline;
+    wakes++;
+}
+
+static void count_callback(Task* task)
+{
+    (void)task;
+    firings++;
+    if (now_us != last_fire_us) {
+        fire_instants++;
+        last_fire_us = now_us;
+    }
+}
+
+int main(void)
+{
+    static Task tasks[3];
+    static const uint32_t intervals[3] = {600, 250, 1000};
+    static Task stopped[2];
+    static const uint32_t stopped_intervals[2] = {0, 100};
+
+    TaskList list;
+    TaskList_Init(&list);
+    for (int i = 0; i < 3; i++) {
+        tasks[i].callback = count_callback;
+        tasks[i].interval = ASYNC_MS(intervals[i]);
+        TaskList_Add(&list, &tasks[i]);
+    }
+    for (int i = 0; i < 2; i++) {
+        stopped[i].callback = count_callback;
+        stopped[i].interval = ASYNC_MS(stopped_intervals[i]);
+        TaskList_Add(&list, &stopped[i]);
+        stopped[i].callback = NULL;
+    }
+
+    uint32_t spins = 0;
+    while (now_us < ASYNC_MS(SIM_MS)) {
+        Update(&list);
+        scheduler_idle(&list);
+        spins++;
+    }
+
+    printf("mode: %s, simulated %u ms\n", ASYNC_TASK_USE_HEAP ? "heap" : "list", SIM_MS);
+    printf("busy-poll wakes: %u\n", SIM_MS / POLL_MS);
+    printf("tickless wakes:  %u (loop spins %u)\n", wakes, spins);
+    printf("task firings:    %u at %u distinct instants (+2 stopped tasks)\n", firings, fire_instants);
+
+    // The last wake may land past SIM_MS before its tasks run
+    if (wakes != fire_instants && wakes != fire_instants + 1) {
+        printf("FAIL: wakes do not match firing instants\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,244 @@
+#include "async_alarm.h"
+
+#ifdef ASYNC_TIME_HOST
+#include <pthread.h>
+#include <time.h>
+#else
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#endif
+
+// One alarm per core: in dual-core mode (ASYNC_TASK_MULTICORE) each core
+// sleeps to its own next deadline, so the cores must not share a target.
+// The host timer thread stands in for a single core's alarm.
+#ifdef ASYNC_TIME_HOST
+#if ASYNC_TASK_MULTICORE
+#error "The host alarm (timer thread) serves one core; build ASYNC_TASK_MULTICORE without ASYNC_ALARM"
+#endif
+#define ALARM_CORES (1)
+#define ALARM_SELF() (&alarms[0])
+#else
+#define ALARM_CORES (NUM_CORES)
+#define ALARM_SELF() (&alarms[get_core_num()])
+#endif
+
+// Shared with the alarm ISR (or the host timer thread)
+typedef struct {
+    volatile bool armed;
+    volatile async_time_t target;
+    async_alarm_stats_t stats;
+#ifndef ASYNC_TIME_HOST
+    bool claimed;
+    uint num;                   // hardware alarm, interrupt enabled on this core only
+#endif
+} alarm_t;
+
+static alarm_t alarms[ALARM_CORES];
+
+static void alarm_event(void);
+
+// ISR body: mark the deadline reached and wake the thread, nothing else
+static void alarm_fire(alarm_t* alarm, async_time_t now)
+{
+    if (!alarm->armed) {
+        return; // Cancelled or re-armed while the interrupt was pending
+    }
+    alarm->armed = false;
+    async_time_t late = async_time_reached(now, alarm->target) ? now - alarm->target : 0;
+    alarm->stats.fired++;
+    alarm->stats.late_total_us += late;
+    if (late > alarm->stats.late_max_us) {
+        alarm->stats.late_max_us = late;
+    }
+    alarm_event();
+}
+
+#ifdef ASYNC_TIME_HOST
+
+// The timer thread plays the alarm hardware; host_event plays the event register
+static pthread_mutex_t host_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t host_timer_cond;     // timer thread: target changed
+static pthread_cond_t host_wake_cond;      // waiters in async_alarm_wait()
+static bool host_event = false;
+static bool host_started = false;
+
+static void alarm_event(void)
+{
+    host_event = true;
+    pthread_cond_broadcast(&host_wake_cond);
+}
+
+static void* host_timer_thread(void* arg)
+{
+    (void)arg;
+    alarm_t* alarm = &alarms[0];
+    pthread_mutex_lock(&host_lock);
+    while (true) {
+        if (!alarm->armed) {
+            pthread_cond_wait(&host_timer_cond, &host_lock);
+            continue;
+        }
+        async_time_t now = async_time_now();
+        if (async_time_reached(now, alarm->target)) {
+            alarm_fire(alarm, now);
+            continue;
+        }
+        // async_time_now() may run on any epoch; only the distance is used
+        async_time_t wait_us = alarm->target - now;
+        struct timespec at;
+        clock_gettime(CLOCK_MONOTONIC, &at);
+        at.tv_sec += (time_t)(wait_us / 1000000u);
+        at.tv_nsec += (long)(wait_us % 1000000u) * 1000;
+        if (at.tv_nsec >= 1000000000) {
+            at.tv_sec++;
+            at.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&host_timer_cond, &host_lock, &at);
+    }
+    return NULL;
+}
+
+void async_alarm_init(void)
+{
+    pthread_mutex_lock(&host_lock);
+    if (!host_started) {
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&host_timer_cond, &attr);
+        pthread_condattr_destroy(&attr);
+        pthread_cond_init(&host_wake_cond, NULL);
+        pthread_t thread;
+        pthread_create(&thread, NULL, host_timer_thread, NULL);
+        pthread_detach(thread);
+        host_started = true;
+    }
+    pthread_mutex_unlock(&host_lock);
+}
+
+void async_alarm_arm(async_time_t deadline)
+{
+    if (!host_started) {
+        async_alarm_init();
+    }
+    alarm_t* alarm = ALARM_SELF();
+    pthread_mutex_lock(&host_lock);
+    if (!alarm->armed || alarm->target != deadline) {
+        alarm->target = deadline;
+        alarm->armed = true;
+        alarm->stats.armed++;
+        pthread_cond_signal(&host_timer_cond);
+    }
+    pthread_mutex_unlock(&host_lock);
+}
+
+void async_alarm_cancel(void)
+{
+    pthread_mutex_lock(&host_lock);
+    ALARM_SELF()->armed = false;
+    pthread_mutex_unlock(&host_lock);
+}
+
+void async_alarm_wait(void)
+{
+    pthread_mutex_lock(&host_lock);
+    while (!host_event) {
+        pthread_cond_wait(&host_wake_cond, &host_lock);
+    }
+    host_event = false;
+    pthread_mutex_unlock(&host_lock);
+}
+
+async_alarm_stats_t async_alarm_stats(void)
+{
+    pthread_mutex_lock(&host_lock);
+    async_alarm_stats_t copy = alarms[0].stats;
+    pthread_mutex_unlock(&host_lock);
+    return copy;
+}
+
+#else
+
+static void alarm_event(void)
+{
+    __sev();
+}
+
+static void alarm_irq(uint num)
+{
+    for (uint core = 0; core < ALARM_CORES; core++) {
+        if (alarms[core].claimed && alarms[core].num == num) {
+            alarm_fire(&alarms[core], async_time_now());
+            return;
+        }
+    }
+}
+
+// Claims an alarm for the calling core and enables its interrupt there
+void async_alarm_init(void)
+{
+    alarm_t* alarm = ALARM_SELF();
+    if (!alarm->claimed) {
+        alarm->num = (uint)hardware_alarm_claim_unused(true);
+        alarm->claimed = true;
+        hardware_alarm_set_callback(alarm->num, alarm_irq);
+    }
+}
+
+void async_alarm_arm(async_time_t deadline)
+{
+    alarm_t* alarm = ALARM_SELF();
+    if (!alarm->claimed) {
+        async_alarm_init();
+    }
+    if (alarm->armed && alarm->target == deadline) {
+        return; // Already armed for this deadline
+    }
+    uint32_t irq = save_and_disable_interrupts();
+    alarm->target = deadline;
+    alarm->armed = true;
+    alarm->stats.armed++;
+    restore_interrupts(irq);
+    // true: the target was already in the past and the alarm was not set
+    if (hardware_alarm_set_target(alarm->num, from_us_since_boot(deadline))) {
+        irq = save_and_disable_interrupts();
+        alarm_fire(alarm, async_time_now());
+        restore_interrupts(irq);
+    }
+}
+
+void async_alarm_cancel(void)
+{
+    alarm_t* alarm = ALARM_SELF();
+    if (alarm->claimed && alarm->armed) {
+        hardware_alarm_cancel(alarm->num);
+        alarm->armed = false;
+    }
+}
+
+// Returns at once if the ISR already ran: its __sev() left the event register set
+void async_alarm_wait(void)
+{
+    __wfe();
+}
+
+// Summed over the cores; each core's counters are only written by its own ISR
+async_alarm_stats_t async_alarm_stats(void)
+{
+    async_alarm_stats_t sum = {0};
+    uint32_t irq = save_and_disable_interrupts();
+    for (uint core = 0; core < ALARM_CORES; core++) {
+        const async_alarm_stats_t* stats = &alarms[core].stats;
+        sum.armed += stats->armed;
+        sum.fired += stats->fired;
+        sum.late_total_us += stats->late_total_us;
+        if (stats->late_max_us > sum.late_max_us) {
+            sum.late_max_us = stats->late_max_us;
+        }
+    }
+    restore_interrupts(irq);
+    return sum;
+}
+
+#endif
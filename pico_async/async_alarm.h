@@ -0,0 +1,48 @@
+#ifndef ASYNC_ALARM_H
+#define ASYNC_ALARM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "async_time.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One-shot alarm for the earliest task deadline, shared by the task schedulers.
+// Build with ASYNC_ALARM=1 (and async_alarm.c) and scheduler_sleep_until() arms
+// a dedicated RP2350 timer alarm instead of going through the SDK alarm pool.
+// The alarm ISR does no scheduling work: it records the wake and raises an
+// event, and the due callbacks run in thread context on the next Update().
+// Each core has its own alarm (dual-core ASYNC_TASK_MULTICORE), claimed by
+// the first call on that core; the functions act on the calling core's.
+//
+// Host builds (ASYNC_TIME_HOST) get a timer thread standing in for the alarm
+// and a condition variable for WFE/SEV, so dispatch latency can be measured
+// against the host clock (see host/bench_alarm.c). It stands in for one core.
+#ifndef ASYNC_ALARM
+#define ASYNC_ALARM 0
+#endif
+
+typedef struct {
+    uint32_t armed;             // alarm programmed for a new deadline
+    uint32_t fired;             // ISR runs (a deadline already past counts too)
+    async_time_t late_max_us;   // ISR entry - deadline
+    async_time_t late_total_us;
+} async_alarm_stats_t;
+
+// Claim the calling core's alarm; called on first use, or up front on each
+// core to keep the claim out of the loop
+void async_alarm_init(void);
+// Fire at deadline (at once if it has passed); replaces any earlier target
+void async_alarm_arm(async_time_t deadline);
+void async_alarm_cancel(void);
+// Wait for the alarm or any other event (interrupt, __sev() from an ISR or the other core)
+void async_alarm_wait(void);
+async_alarm_stats_t async_alarm_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
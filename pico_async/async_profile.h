@@ -0,0 +1,98 @@
+#ifndef ASYNC_PROFILE_H
+#define ASYNC_PROFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "async_time.h"
+
+// Per-task runtime profile shared by the task schedulers.
+// Build with ASYNC_PROFILE=1; with 0 (default) the schedulers compile the
+// instrumentation out completely and none of this is used.
+#ifndef ASYNC_PROFILE
+#define ASYNC_PROFILE 0
+#endif
+
+// Duration histogram: bucket 0 is < 1 us, bucket i is [2^(i-1), 2^i) us,
+// the last bucket collects everything longer
+#ifndef ASYNC_PROFILE_BUCKETS
+#define ASYNC_PROFILE_BUCKETS (16)
+#endif
+
+typedef struct {
+    const void *task;           // profiled task, NULL for an unused entry
+    uint32_t runs;
+    uint32_t overruns;          // runs that finished after the task's deadline
+    async_time_t min_us;        // callback duration
+    async_time_t max_us;
+    async_time_t total_us;
+    async_time_t late_max_us;   // dispatch lateness: start - next_run_at
+    async_time_t late_total_us;
+    uint32_t hist[ASYNC_PROFILE_BUCKETS];
+} async_task_profile_t;
+
+typedef struct {
+    async_time_t since;         // start of the measurement window
+    async_time_t busy_us;       // time spent in callbacks
+    uint32_t passes;            // scheduler passes (Update() / async_tasks_update() calls)
+} async_loop_profile_t;
+
+static inline uint32_t async_profile_bucket(async_time_t us)
+{
+    uint32_t bucket = 0;
+    while (us != 0 && bucket < ASYNC_PROFILE_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+// One callback run: started at start, ended at end, was due at due.
+// period is the task's relative deadline (0 = none, never an overrun).
+static inline void async_profile_record(async_task_profile_t *p, async_time_t start, async_time_t end,
+                                        async_time_t due, async_time_t period)
+{
+    async_time_t duration = end - start;
+    async_time_t late = async_time_reached(start, due) ? start - due : 0;
+    if (p->runs == 0 || duration < p->min_us) {
+        p->min_us = duration;
+    }
+    if (duration > p->max_us) {
+        p->max_us = duration;
+    }
+    p->runs++;
+    p->total_us += duration;
+    if (late > p->late_max_us) {
+        p->late_max_us = late;
+    }
+    p->late_total_us += late;
+    if (period != 0 && async_time_before(due + period, end)) {
+        p->overruns++;
+    }
+    p->hist[async_profile_bucket(duration)]++;
+}
+
+static inline void async_profile_print_header(const async_loop_profile_t *loop, async_time_t now)
+{
+    async_time_t window = now - loop->since;
+    printf("loop: %lu passes, busy %llu of %llu us (%lu%%)\n", (unsigned long)loop->passes,
+           (unsigned long long)loop->busy_us, (unsigned long long)window,
+           (unsigned long)(window ? loop->busy_us * 100u / window : 0));
+    printf("task       runs  over   min   avg   max  late avg/max  histogram (log2 us)\n");
+}
+
+static inline void async_profile_print(const async_task_profile_t *p)
+{
+    if (p->task == NULL || p->runs == 0) {
+        return;
+    }
+    printf("%p %6lu %5lu %5llu %5llu %5llu %5llu/%-6llu", p->task, (unsigned long)p->runs,
+           (unsigned long)p->overruns, (unsigned long long)p->min_us,
+           (unsigned long long)(p->total_us / p->runs), (unsigned long long)p->max_us,
+           (unsigned long long)(p->late_total_us / p->runs), (unsigned long long)p->late_max_us);
+    for (uint32_t i = 0; i < ASYNC_PROFILE_BUCKETS; i++) {
+        printf(" %lu", (unsigned long)p->hist[i]);
+    }
+    printf("\n");
+}
+
+#endif
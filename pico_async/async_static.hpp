@@ -0,0 +1,139 @@
+#ifndef ASYNC_STATIC_HPP
+#define ASYNC_STATIC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include "async_time.h"
+
+#ifndef ASYNC_TIME_HOST
+#include "pico/stdlib.h"
+#endif
+
+// Compile-time task table (C++17, header only).
+//
+// The task set is a tuple of periodic_task objects whose context type, callback
+// and interval are template parameters. The dispatch loop is unrolled over the
+// tuple, so every callback is a direct (usually inlined) call: no Task list, no
+// function pointers, no TaskList_Add() at startup, and the callback gets its
+// own context type instead of a Task* to cast back.
+//
+//   struct led_t { uint pin; bool state; };
+//   static void led_toggle(led_t& led) { led.state = !led.state; gpio_put(led.pin, led.state); }
+//
+//   static async::task_table tasks{
+//       async::periodic_task<led_t, led_toggle, ASYNC_MS(600)>{{LED_1, false}},
+//       async::periodic_task<led_t, led_toggle, ASYNC_MS(250)>{{LED_2, false}},
+//   };
+//
+//   int main() { ...; tasks.run(); }
+//
+// A table with literal contexts is constant-initialized (it lands in .data),
+// and each task is first due one interval after boot, like TaskList_Add() at
+// power-up. Missed periods follow CATCH_UP_SKIP: run once, count the missed
+// periods, keep the phase. Tasks cannot be added or removed at run time; use
+// the TaskList scheduler (async_task.h) for that.
+
+#ifdef ASYNC_TIME_HOST
+// Host builds supply the sleep, as for the C schedulers
+extern "C" void scheduler_sleep_until(async_time_t deadline);
+#endif
+
+namespace async {
+
+template <typename Context, void (*Callback)(Context&), async_time_t Interval>
+struct periodic_task {
+    static_assert(Interval > 0, "periodic_task needs a non-zero interval");
+
+    static constexpr async_time_t interval = Interval;
+    using context_type = Context;
+
+    Context context;
+    async_time_t next_run_at = Interval;
+    uint32_t missed = 0;            // periods skipped because the loop was late
+
+    constexpr explicit periodic_task(const Context& ctx) : context(ctx) {}
+
+    // Run if due; same phase-anchored reschedule as task_reschedule()
+    bool poll(async_time_t now) {
+        if (!async_time_reached(now, next_run_at)) {
+            return false;
+        }
+        Callback(context);
+        if (async_time_before(now, next_run_at + Interval)) {
+            next_run_at += Interval;
+        } else {
+            async_time_t periods = (now - next_run_at) / Interval;
+            missed += (uint32_t)periods;
+            next_run_at += (periods + 1) * Interval;
+        }
+        return true;
+    }
+};
+
+template <typename... Tasks>
+class task_table {
+public:
+    static constexpr std::size_t size = sizeof...(Tasks);
+    static_assert(size > 0, "task_table needs at least one task");
+
+    constexpr explicit task_table(const Tasks&... tasks) : tasks_(tasks...) {}
+
+    // Typed access: tasks.get<0>().context, tasks.context<1>().pin
+    template <std::size_t I>
+    auto& get() { return std::get<I>(tasks_); }
+
+    template <std::size_t I>
+    auto& context() { return std::get<I>(tasks_).context; }
+
+    // Re-phase every task to start one interval from now (the table starts at boot otherwise)
+    void start(async_time_t now) {
+        std::apply([now](auto&... task) { ((task.next_run_at = now + task.interval), ...); }, tasks_);
+    }
+
+    // One pass over the table in declaration order; returns the number of callbacks run
+    uint32_t update(async_time_t now) {
+        return std::apply([now](auto&... task) { return (0u + ... + (uint32_t)task.poll(now)); }, tasks_);
+    }
+
+    uint32_t update() { return update(async_time_now()); }
+
+    // Earliest next_run_at in the table
+    async_time_t next_deadline() const {
+        async_time_t deadline = std::get<0>(tasks_).next_run_at;
+        std::apply([&deadline](const auto&... task) {
+            ((deadline = async_time_before(task.next_run_at, deadline) ? task.next_run_at : deadline), ...);
+        }, tasks_);
+        return deadline;
+    }
+
+    // Sleep until the next task is due; an interrupt or __sev() ends the sleep early
+    void idle() {
+        async_time_t deadline = next_deadline();
+        if (async_time_before(async_time_now(), deadline)) {
+#ifdef ASYNC_TIME_HOST
+            scheduler_sleep_until(deadline);
+#else
+            best_effort_wfe_or_timeout(from_us_since_boot(deadline));
+#endif
+        }
+    }
+
+    [[noreturn]] void run() {
+        while (true) {
+            update();
+            idle();
+        }
+    }
+
+private:
+    std::tuple<Tasks...> tasks_;
+};
+
+template <typename... Tasks>
+task_table(Tasks...) -> task_table<Tasks...>;
+
+} // namespace async
+
+#endif
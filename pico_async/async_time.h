@@ -0,0 +1,49 @@
+#ifndef ASYNC_TIME_H
+#define ASYNC_TIME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Monotonic time base shared by the task schedulers.
+// async_time_t is microseconds since boot; 64 bits do not wrap in the life of a device.
+typedef uint64_t async_time_t;
+
+// Interval helpers: task->interval = ASYNC_MS(250);
+#define ASYNC_US(us)    ((async_time_t)(us))
+#define ASYNC_MS(ms)    ((async_time_t)(ms) * 1000u)
+#define ASYNC_SEC(s)    ((async_time_t)(s) * 1000000u)
+
+// Host builds (ASYNC_TIME_HOST) supply their own clock, e.g. a virtual one
+#ifdef ASYNC_TIME_HOST
+#ifdef __cplusplus
+extern "C" async_time_t async_time_now(void);
+#else
+async_time_t async_time_now(void);
+#endif
+#else
+#include "hardware/timer.h"
+
+static inline async_time_t async_time_now(void)
+{
+    return time_us_64();
+}
+#endif
+
+// Comparisons use the signed difference, so they stay correct across a wrap
+// (including for stamps truncated to fewer bits by the caller)
+static inline int64_t async_time_diff(async_time_t a, async_time_t b)
+{
+    return (int64_t)(a - b);
+}
+
+static inline bool async_time_before(async_time_t a, async_time_t b)
+{
+    return async_time_diff(a, b) < 0;
+}
+
+static inline bool async_time_reached(async_time_t now, async_time_t deadline)
+{
+    return async_time_diff(now, deadline) >= 0;
+}
+
+#endif
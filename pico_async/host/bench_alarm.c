@@ -0,0 +1,238 @@
+// Dispatch latency of a sub-millisecond task on the host clock.
+//
+// Built once per scheduler and wake-up source (see CMakeLists.txt):
+//  - ASYNC_ALARM=1: scheduler_sleep_until() arms async_alarm, whose host
+//    version is a timer thread firing a condition variable (alarm ISR + WFE)
+//  - ASYNC_ALARM=0: scheduler_sleep_until() below sleeps to the deadline
+//    directly, or with -m the loop polls every millisecond like the old
+//    sleep_ms() main loops
+//
+// A fast sampling task (-p us, default 250) runs next to a 1 ms and a 10 ms
+// task for -t seconds. Reported: lateness of the fast task's runs (callback
+// start minus next_run_at) as percentiles and a log2 histogram, its missed
+// periods, and for the alarm build how often the alarm was armed and fired.
+// Numbers depend on the host's timer slack and load; compare builds on the
+// same machine.
+//
+//   bench_alarm_list -p 250 -t 5
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include "async_task.h"
+#include "async_alarm.h"
+
+#ifdef SIM_TOF
+#define BENCH_SCHEDULER (ASYNC_TASK_USE_WHEEL ? "tof_distance wheel" : "tof_distance array")
+#else
+#define BENCH_SCHEDULER (ASYNC_TASK_USE_HEAP ? "async_tasks heap" : "async_tasks list")
+#endif
+
+#define LATE_BUCKETS (24)   // log2 us: bucket 0 is 0 us, bucket i is [2^(i-1), 2^i) us
+#define MAX_SAMPLES (1u << 22)
+
+static struct timespec start_ts;
+static async_time_t* samples;
+static uint32_t sample_count = 0;
+static uint32_t hist[LATE_BUCKETS];
+
+// Host clock in us since the benchmark started
+async_time_t async_time_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (async_time_t)(ts.tv_sec - start_ts.tv_sec) * 1000000u + (async_time_t)(ts.tv_nsec / 1000) -
+           (async_time_t)(start_ts.tv_nsec / 1000);
+}
+
+#if !ASYNC_ALARM
+// Direct sleep to the deadline, standing in for best_effort_wfe_or_timeout()
+void scheduler_sleep_until(async_time_t deadline)
+{
+    if (deadline == SCHEDULER_NO_DEADLINE) {
+        deadline = async_time_now() + ASYNC_MS(1);
+    }
+    async_time_t at = deadline + (async_time_t)(start_ts.tv_nsec / 1000);
+    struct timespec ts = {start_ts.tv_sec + (time_t)(at / 1000000u), (long)(at % 1000000u) * 1000};
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+#endif
+
+static void record(async_time_t due)
+{
+    async_time_t now = async_time_now();
+    async_time_t late = async_time_reached(now, due) ? now - due : 0;
+    uint32_t bucket = 0;
+    for (async_time_t v = late; v != 0 && bucket < LATE_BUCKETS - 1; v >>= 1) {
+        bucket++;
+    }
+    hist[bucket]++;
+    if (sample_count < MAX_SAMPLES) {
+        samples[sample_count++] = late;
+    }
+}
+
+static int cmp_time(const void* a, const void* b)
+{
+    async_time_t x = *(const async_time_t*)a, y = *(const async_time_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+// ---- Scheduler adapters ----
+
+#ifdef SIM_TOF
+
+static Task* fast_task;
+static async_time_t fast_due;
+
+// tof_distance reschedules before the callback: next_run_at is already the next release
+static void fast_callback(Task* task)
+{
+    record(fast_due);
+    fast_due = task->next_run_at;
+}
+
+static void slow_callback(Task* task)
+{
+    (void)task;
+}
+
+static void bench_add(async_time_t interval, TaskCallback callback)
+{
+    Task* pt = task_add();
+    pt->interval = interval;
+    pt->callback = callback;
+    task_sleep_until(pt, async_time_now() + interval);
+    if (callback == fast_callback) {
+        fast_task = pt;
+        fast_due = pt->next_run_at;
+    }
+}
+
+static void bench_update(void)
+{
+    async_tasks_update();
+}
+
+static void bench_idle(void)
+{
+    scheduler_idle();
+}
+
+static uint32_t bench_missed(void)
+{
+    return fast_task->missed;
+}
+
+#else
+
+static TaskList list;
+static Task tasks[3];
+
+static void fast_callback(Task* task)
+{
+    record(task->next_run_at);
+}
+
+static void slow_callback(Task* task)
+{
+    (void)task;
+}
+
+static void bench_add(async_time_t interval, TaskCallback callback)
+{
+    static uint32_t count = 0;
+    if (count == 0) {
+        TaskList_Init(&list);
+    }
+    Task* task = &tasks[count++];
+    task->interval = interval;
+    task->callback = callback;
+    TaskList_Add(&list, task);
+}
+
+static void bench_update(void)
+{
+    Update(&list);
+}
+
+static void bench_idle(void)
+{
+    scheduler_idle(&list);
+}
+
+static uint32_t bench_missed(void)
+{
+    return tasks[0].missed;
+}
+
+#endif
+
+int main(int argc, char** argv)
+{
+    unsigned long period_us = 250;
+    unsigned long seconds = 5;
+    int poll_ms = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:t:mh")) != -1) {
+        switch (opt) {
+        case 'p': period_us = strtoul(optarg, NULL, 0); break;
+        case 't': seconds = strtoul(optarg, NULL, 0); break;
+        case 'm': poll_ms = 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-p fast_period_us] [-t seconds] [-m (poll every 1 ms)]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (period_us == 0 || seconds == 0) {
+        fprintf(stderr, "%s: period and duration must be non-zero\n", argv[0]);
+        return 2;
+    }
+    samples = malloc(MAX_SAMPLES * sizeof(async_time_t));
+    if (samples == NULL) {
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start_ts);
+#if ASYNC_ALARM
+    async_alarm_init();
+#endif
+
+    bench_add(ASYNC_US(period_us), fast_callback);
+    bench_add(ASYNC_MS(1), slow_callback);
+    bench_add(ASYNC_MS(10), slow_callback);
+
+    async_time_t end = ASYNC_SEC(seconds);
+    while (async_time_before(async_time_now(), end)) {
+        bench_update();
+        if (poll_ms) {
+            usleep(1000);
+        } else {
+            bench_idle();
+        }
+    }
+
+    const char* wake = ASYNC_ALARM ? "alarm" : poll_ms ? "1 ms poll" : "direct sleep";
+    printf("scheduler: %s, wake-up: %s, fast task %lu us for %lu s\n", BENCH_SCHEDULER, wake, period_us, seconds);
+    if (sample_count == 0) {
+        printf("no runs\n");
+        return 1;
+    }
+    qsort(samples, sample_count, sizeof(async_time_t), cmp_time);
+    printf("runs %u, missed periods %u\n", sample_count, bench_missed());
+    printf("lateness us: p50 %llu  p90 %llu  p99 %llu  max %llu\n",
+           (unsigned long long)samples[sample_count / 2], (unsigned long long)samples[sample_count * 9 / 10],
+           (unsigned long long)samples[sample_count * 99 / 100], (unsigned long long)samples[sample_count - 1]);
+    printf("histogram (log2 us):");
+    for (uint32_t i = 0; i < LATE_BUCKETS; i++) {
+        printf(" %u", hist[i]);
+    }
+    printf("\n");
+#if ASYNC_ALARM
+    async_alarm_stats_t stats = async_alarm_stats();
+    printf("alarm: armed %u, fired %u, ISR late avg %llu max %llu us\n", stats.armed, stats.fired,
+           (unsigned long long)(stats.fired ? stats.late_total_us / stats.fired : 0),
+           (unsigned long long)stats.late_max_us);
+#endif
+    free(samples);
+    return 0;
+}
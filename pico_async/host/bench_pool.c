@@ -0,0 +1,113 @@
+// Host benchmark of the tof_distance slot array: Task structs (ASYNC_TASK_USE_SOA=0)
+// against the hot deadline table (ASYNC_TASK_USE_SOA=1).
+//
+// Built once per layout and pool size (MAX_TASKS = 16, 256, 4096, see
+// CMakeLists.txt). The pool is filled to -f percent with tasks of random
+// 10..999 ms intervals, then async_tasks_update() runs once per simulated ms
+// on a virtual clock, followed by scheduler_next_deadline() as the tickless
+// loop would call it. Reported: ns per pass (the due check plus dispatch of
+// empty callbacks), ns per dispatch and ns per next-deadline search.
+//
+//   bench_pool_soa_4096 -f 50
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include "async_task.h"
+
+#define SIM_MS      (20000u)    // simulated run time
+
+static async_time_t now_us = 0;
+static uint32_t fired = 0;
+
+// Virtual clock used by async_task.c in host builds
+async_time_t async_time_now(void)
+{
+    return now_us;
+}
+
+// Not used here: the benchmark calls the update once per simulated ms
+void scheduler_sleep_until(async_time_t deadline)
+{
+    (void)deadline;
+}
+
+static void count_callback(Task* task)
+{
+    (void)task;
+    fired++;
+}
+
+// Small deterministic generator so both layouts see the same task mix
+static uint32_t rng_state = 12345u;
+static uint32_t rng_next(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static double elapsed_ns(const struct timespec* a, const struct timespec* b)
+{
+    return (double)(b->tv_sec - a->tv_sec) * 1e9 + (double)(b->tv_nsec - a->tv_nsec);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned long fill = 100;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:h")) != -1) {
+        switch (opt) {
+        case 'f': fill = strtoul(optarg, NULL, 0); break;
+        default:
+            fprintf(stderr, "usage: %s [-f pool fill %%]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (fill == 0 || fill > 100) {
+        fprintf(stderr, "%s: fill is 1..100%%\n", argv[0]);
+        return 2;
+    }
+
+    // Spread the tasks over the pool: add all, then delete every slot not kept
+    uint32_t kept = 0;
+    static Task* added[MAX_TASKS];
+    for (uint32_t i = 0; i < MAX_TASKS; i++) {
+        added[i] = task_add();
+    }
+    for (uint32_t i = 0; i < MAX_TASKS; i++) {
+        if (rng_next() % 100 >= fill) {
+            task_delete(added[i]);
+            continue;
+        }
+        added[i]->callback = count_callback;
+        added[i]->interval = ASYNC_MS(10 + rng_next() % 990);
+        task_sleep_until(added[i], added[i]->interval);
+        kept++;
+    }
+
+    struct timespec t0, t1;
+    double deadline_ns = 0;
+    double update_ns = 0;
+    async_time_t sink = 0;
+    for (uint32_t ms = 1; ms <= SIM_MS; ms++) {
+        now_us = ASYNC_MS(ms);
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        async_tasks_update();
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        update_ns += elapsed_ns(&t0, &t1);
+
+        async_time_t deadline = 0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        scheduler_next_deadline(&deadline);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        deadline_ns += elapsed_ns(&t0, &t1);
+        sink += deadline;
+    }
+
+    printf("layout: %s, pool %u, tasks %u, %u ms\n", ASYNC_TASK_USE_SOA ? "soa" : "task structs", (unsigned)MAX_TASKS,
+           kept, SIM_MS);
+    printf("%10s %12s %14s %16s\n", "fired", "ns/pass", "ns/dispatch", "ns/next_deadline");
+    printf("%10u %12.1f %14.1f %16.1f\n", fired, update_ns / SIM_MS, fired ? update_ns / fired : 0.0,
+           deadline_ns / SIM_MS);
+    return sink == 0;
+}
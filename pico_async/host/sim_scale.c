@@ -0,0 +1,401 @@
+// Discrete-event simulation of a scheduler at scale on a virtual clock.
+//
+// Built once per scheduler (see CMakeLists.txt): async_tasks (list or heap)
+// or tof_distance (slot array or timing wheel). The main loop is the real one,
+// update followed by scheduler_idle(), and scheduler_sleep_until() jumps the
+// clock straight to the next deadline, so simulated days take seconds.
+//
+// Each task gets a log-uniform random interval and a random callback cost;
+// a callback advances the virtual clock by its cost, so a loaded system
+// really runs late. Reported:
+//  - dispatch overhead: host ns per dispatch and per pass (scheduler plus the
+//    harness bookkeeping, no callback work)
+//  - lateness: start of each run minus its release on the task's phase grid
+//  - missed deadlines: releases that never got a run (implicit deadline = one
+//    interval), next to the scheduler's own Task.missed count
+//  - early runs: a run before its release or twice for one release; must be 0
+//
+//   sim_scale_heap -n 1000 -t 86400 -i 1000 -I 3600000        (a day, 10^3 tasks)
+//   sim_scale_tof_wheel -n 1000000 -t 600 -i 1000 -I 3600000  (10 minutes, 10^6 tasks)
+//
+// -x adds stopped tasks (tof_distance only: task_add() without a callback),
+// which must neither run nor wake the core. -j makes each wake up to that
+// many us late, as a real core is, so pass times fall between wheel ticks:
+//   sim_scale_tof_wheel -n 2 -t 10 -i 500 -I 500 -j 100 -x 1 -W 50
+//
+// Exit status is non-zero if there were early runs, or if -L/-M/-W limits on
+// p99 lateness, the missed-deadline ratio or the number of wakes are
+// exceeded, so a run can gate a scheduler change.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include "async_task.h"
+
+#ifdef SIM_TOF
+#define SIM_SCHEDULER (ASYNC_TASK_USE_WHEEL ? "tof_distance wheel" : ASYNC_TASK_USE_SOA ? "tof_distance soa" : "tof_distance array")
+#define SIM_MAX_TASKS (MAX_TASKS)
+#else
+#define SIM_SCHEDULER (ASYNC_TASK_USE_HEAP ? "async_tasks heap" : "async_tasks list")
+#define SIM_MAX_TASKS (1u << 24)
+#endif
+
+#define LATE_BUCKETS (40)   // log2 us: bucket 0 is 0 us, bucket i is [2^(i-1), 2^i) us
+
+typedef struct {
+    Task* task;
+    uint64_t interval;
+    uint64_t last_release;  // index on the phase grid of the last run (0 = none yet)
+} sim_task_t;
+
+static async_time_t now_us = 0;
+static async_time_t pass_us = 0;    // clock at the start of the current pass
+static async_time_t end_us = 0;
+static uint32_t wake_late_us = 0;   // -j: wakes are 0..wake_late_us late
+static sim_task_t* sim;
+static uint32_t sim_count;
+static double cost_mean;            // us per callback, the same for every task
+
+static uint64_t dispatches = 0;
+static uint64_t passes = 0;
+static uint64_t wakes = 0;
+static uint64_t busy_us = 0;
+static uint64_t missed = 0;         // releases without a run
+static uint64_t releases = 0;       // releases that were due (run or missed)
+static uint64_t early = 0;
+static uint64_t late_hist[LATE_BUCKETS];
+static uint64_t late_max = 0;
+static uint64_t late_total = 0;
+
+// Virtual clock used by the scheduler in host builds
+async_time_t async_time_now(void)
+{
+    return now_us;
+}
+
+// Sleeping jumps the clock straight to the deadline
+void scheduler_sleep_until(async_time_t deadline)
+{
+    if (deadline == SCHEDULER_NO_DEADLINE || async_time_before(end_us, deadline)) {
+        deadline = end_us;
+    }
+    if (async_time_before(now_us, deadline)) {
+        // Spread over 0..wake_late_us without touching the task mix's random sequence
+        now_us = deadline + (wake_late_us ? wakes * 7919 % (wake_late_us + 1) : 0);
+    }
+    wakes++;
+}
+
+// xorshift64*, deterministic for a given seed
+static uint64_t rng_state;
+static uint64_t rng_next(void)
+{
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 2685821657736338717ull;
+}
+
+static double rng_unit(void)
+{
+    return (double)(rng_next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static uint32_t late_bucket(uint64_t us)
+{
+    uint32_t bucket = 0;
+    while (us != 0 && bucket < LATE_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+// Upper bound of the bucket holding the q-th fraction of all runs
+static uint64_t late_percentile(double q)
+{
+    uint64_t target = (uint64_t)ceil(q * (double)dispatches);
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < LATE_BUCKETS; i++) {
+        seen += late_hist[i];
+        if (seen >= target && seen != 0) {
+            return i == 0 ? 0 : (1ull << i) - 1;
+        }
+    }
+    return late_max;
+}
+
+static void sim_run(sim_task_t* st)
+{
+    // Releases are at k * interval (k >= 1). The scheduler decides on the time
+    // it read at the start of the pass, so the latest release by then is this
+    // run's, even if earlier callbacks of the pass have pushed the clock past
+    // the next one.
+    uint64_t k = pass_us / st->interval;
+    if (k <= st->last_release) {
+        early++;
+        return;
+    }
+    uint64_t late = now_us - k * st->interval;
+    missed += k - st->last_release - 1;
+    st->last_release = k;
+    late_hist[late_bucket(late)]++;
+    late_total += late;
+    if (late > late_max) {
+        late_max = late;
+    }
+    dispatches++;
+
+    // Cost uniform in [0, 2 * mean], rounded to whole us at random so the mean
+    // load stays as configured when the mean is below 1 us
+    double x = rng_unit() * 2.0 * cost_mean;
+    uint64_t cost = (uint64_t)x;
+    if (rng_unit() < x - (double)cost) {
+        cost++;
+    }
+    now_us += cost;
+    busy_us += cost;
+}
+
+// ---- Scheduler adapters ----
+
+#ifdef SIM_TOF
+
+static void sim_callback(Task* task)
+{
+    sim_run(&sim[task->user.value]);
+}
+
+static bool sim_add(uint32_t index)
+{
+    Task* pt = task_add();
+    if (pt == NULL) {
+        return false;
+    }
+    sim[index].task = pt;
+    pt->user.value = index;
+    pt->interval = sim[index].interval;
+    pt->callback = sim_callback;
+    task_sleep_until(pt, sim[index].interval);  // first release one interval after start
+    return true;
+}
+
+// A slot that is taken but never given a callback
+static bool sim_add_stopped(void)
+{
+    return task_add() != NULL;
+}
+
+static void sim_update(void)
+{
+    async_tasks_update();
+}
+
+static void sim_idle(void)
+{
+    scheduler_idle();
+}
+
+#else
+
+typedef struct {
+    Task task;
+    uint32_t index;
+} sim_slot_t;
+
+static TaskList list;
+static sim_slot_t* slots;
+
+static void sim_callback(Task* task)
+{
+    sim_run(&sim[((sim_slot_t*)task)->index]);
+}
+
+static bool sim_add(uint32_t index)
+{
+    if (index == 0) {
+        TaskList_Init(&list);
+        slots = calloc(sim_count, sizeof(sim_slot_t));
+        if (slots == NULL) {
+            return false;
+        }
+    }
+    sim[index].task = &slots[index].task;
+    slots[index].index = index;
+    slots[index].task.callback = sim_callback;
+    slots[index].task.interval = sim[index].interval;
+    TaskList_Add(&list, sim[index].task);   // first release one interval after start
+    return true;
+}
+
+// A TaskList refuses tasks without a callback
+static bool sim_add_stopped(void)
+{
+    return false;
+}
+
+static void sim_update(void)
+{
+    Update(&list);
+}
+
+static void sim_idle(void)
+{
+    scheduler_idle(&list);
+}
+
+#endif
+
+static double elapsed_ns(const struct timespec* a, const struct timespec* b)
+{
+    return (double)(b->tv_sec - a->tv_sec) * 1e9 + (double)(b->tv_nsec - a->tv_nsec);
+}
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+            "usage: %s [-n tasks] [-t seconds] [-i min_ms] [-I max_ms] [-u load%%] [-s seed]\n"
+            "          [-j wake_late_us] [-x stopped_tasks] [-L max_p99_late_us] [-M max_missed_ppm] [-W max_wakes]\n"
+            "defaults: -n 1000 -t 3600 -i 10 -I 10000 -u 50 -s 1 -j 0 -x 0\n",
+            prog);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t n = 1000;
+    double seconds = 3600;
+    double min_ms = 10;
+    double max_ms = 10000;
+    double load = 50;
+    uint64_t seed = 1;
+    long long max_p99 = -1;
+    long long max_missed_ppm = -1;
+    long long max_wakes = -1;
+    uint32_t stopped = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:i:I:u:s:j:x:L:M:W:h")) != -1) {
+        switch (opt) {
+        case 'n': n = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 't': seconds = atof(optarg); break;
+        case 'i': min_ms = atof(optarg); break;
+        case 'I': max_ms = atof(optarg); break;
+        case 'u': load = atof(optarg); break;
+        case 's': seed = strtoull(optarg, NULL, 0); break;
+        case 'L': max_p99 = atoll(optarg); break;
+        case 'M': max_missed_ppm = atoll(optarg); break;
+        case 'j': wake_late_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'x': stopped = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'W': max_wakes = atoll(optarg); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (n == 0 || n > SIM_MAX_TASKS || min_ms <= 0 || max_ms < min_ms) {
+        fprintf(stderr, "%s: 1..%u tasks, 0 < min_ms <= max_ms\n", argv[0], (unsigned)SIM_MAX_TASKS);
+        return 2;
+    }
+
+    // Intervals log-uniform in [min, max]; one mean callback cost for all tasks,
+    // chosen so that the callbacks take the requested share of the CPU
+    sim_count = n;
+    sim = calloc(n, sizeof(sim_task_t));
+    if (sim == NULL) {
+        return 1;
+    }
+    rng_state = seed * 0x9E3779B97F4A7C15ull | 1;
+    double ratio = log(max_ms / min_ms);
+    double rate = 0;    // runs per second, all tasks
+    for (uint32_t i = 0; i < n; i++) {
+        double ms = min_ms * exp(rng_unit() * ratio);
+        sim[i].interval = (uint64_t)(ms * 1000.0);
+        if (sim[i].interval == 0) {
+            sim[i].interval = 1;
+        }
+        rate += 1e6 / (double)sim[i].interval;
+    }
+    cost_mean = load / 100.0 * 1e6 / rate;
+
+    for (uint32_t i = 0; i < n; i++) {
+        if (!sim_add(i)) {
+            fprintf(stderr, "task %u: scheduler full\n", i);
+            return 1;
+        }
+    }
+    for (uint32_t i = 0; i < stopped; i++) {
+        if (!sim_add_stopped()) {
+            fprintf(stderr, "stopped task %u: scheduler full or no stopped tasks\n", i);
+            return 1;
+        }
+    }
+
+    end_us = (async_time_t)(seconds * 1e6);
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    while (async_time_before(now_us, end_us)) {
+        pass_us = now_us;
+        sim_update();
+        passes++;
+        sim_idle();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ns = elapsed_ns(&t0, &t1);
+
+    // Releases that were due by the end but never ran also count as missed
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t due = end_us / sim[i].interval;
+        if (due > sim[i].last_release) {
+            missed += due - sim[i].last_release - 1;
+        }
+    }
+    releases = dispatches + missed;
+    uint64_t sched_missed = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        sched_missed += sim[i].task->missed;
+    }
+
+    printf("scheduler: %s\n", SIM_SCHEDULER);
+    printf("tasks %u (+%u stopped), intervals %.3g..%.3g ms, load %.0f%%, simulated %.0f s, seed %llu\n", n, stopped, min_ms, max_ms,
+           load, seconds, (unsigned long long)seed);
+    printf("mean callback %.2f us; passes %llu, wakes %llu, dispatches %llu, busy %.1f%%\n", cost_mean,
+           (unsigned long long)passes,
+           (unsigned long long)wakes, (unsigned long long)dispatches,
+           100.0 * (double)busy_us / (double)end_us);
+    printf("overhead: %.1f ns/dispatch, %.1f ns/pass, %.2f s host time\n", dispatches ? ns / dispatches : 0.0,
+           passes ? ns / passes : 0.0, ns / 1e9);
+    printf("lateness us (percentiles are log2 bucket bounds): avg %.1f  p50 %llu  p90 %llu  p99 %llu  p99.9 %llu  max %llu\n",
+           dispatches ? (double)late_total / dispatches : 0.0, (unsigned long long)late_percentile(0.5),
+           (unsigned long long)late_percentile(0.9), (unsigned long long)late_percentile(0.99),
+           (unsigned long long)late_percentile(0.999), (unsigned long long)late_max);
+    printf("lateness histogram (log2 us):");
+    for (uint32_t i = 0; i < LATE_BUCKETS; i++) {
+        if (late_hist[i]) {
+            printf(" [%u]%llu", i, (unsigned long long)late_hist[i]);
+        }
+    }
+    printf("\n");
+    uint64_t missed_ppm = releases ? missed * 1000000u / releases : 0;
+    printf("missed deadlines: %llu of %llu releases (%llu ppm), scheduler Task.missed %llu\n",
+           (unsigned long long)missed, (unsigned long long)releases, (unsigned long long)missed_ppm,
+           (unsigned long long)sched_missed);
+    printf("early runs: %llu\n", (unsigned long long)early);
+
+    int rc = 0;
+    if (early) {
+        rc = 1;
+    }
+    if (max_p99 >= 0 && late_percentile(0.99) > (uint64_t)max_p99) {
+        printf("FAIL: p99 lateness over %lld us\n", max_p99);
+        rc = 1;
+    }
+    if (max_missed_ppm >= 0 && missed_ppm > (uint64_t)max_missed_ppm) {
+        printf("FAIL: missed deadlines over %lld ppm\n", max_missed_ppm);
+        rc = 1;
+    }
+    if (max_wakes >= 0 && wakes > (uint64_t)max_wakes) {
+        printf("FAIL: %llu wakes, over %lld\n", (unsigned long long)wakes, max_wakes);
+        rc = 1;
+    }
+    return rc;
+}
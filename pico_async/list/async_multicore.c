@@ -0,0 +1,135 @@
+#include <stddef.h>
+#ifndef ASYNC_TASK_HOST
+#include "pico/stdlib.h"
+#endif
+#include "async_multicore.h"
+#include "spsc_ring.h"
+
+#if ASYNC_TASK_MULTICORE
+
+typedef struct {
+    TaskList list;
+    spsc_ring_t inbox;      // Task* records arriving from the other core
+    Task* inbox_buf[ASYNC_HANDOFF_SIZE];
+    Task* outbox[ASYNC_HANDOFF_SIZE]; // migrations requested during this pass
+    uint32_t outbox_count;
+    uint8_t outbox_core[ASYNC_HANDOFF_SIZE];
+    CoreLoad load;
+} CoreScheduler;
+
+static CoreScheduler cores[ASYNC_CORES];
+
+#ifndef ASYNC_TASK_HOST
+uint32_t async_core_num(void)
+{
+    return get_core_num();
+}
+#endif
+
+void Multicore_Init(void) {
+    for (uint32_t i = 0; i < ASYNC_CORES; i++) {
+        TaskList_Init(&cores[i].list);
+        spsc_ring_init(&cores[i].inbox, cores[i].inbox_buf, sizeof(Task*), ASYNC_HANDOFF_SIZE);
+        cores[i].outbox_count = 0;
+        cores[i].load = (CoreLoad){0};
+    }
+}
+
+// Add a task to a core's list; from the other core it goes through the handoff queue
+bool Multicore_Add(Task* task, uint32_t core) {
+    if (task == NULL || core >= ASYNC_CORES) {
+        return false;
+    }
+    task->core = (uint8_t)core;
+    if (core == async_core_num()) {
+        TaskList_Add(&cores[core].list, task);
+        return true;
+    }
+    return spsc_ring_push(&cores[core].inbox, &task);
+}
+
+// Request a move to another core. The handoff happens after the current pass,
+// so a task may migrate itself from its own callback.
+bool Multicore_Migrate(Task* task, uint32_t core) {
+    uint32_t me = async_core_num();
+    CoreScheduler* self = &cores[me];
+    if (task == NULL || core >= ASYNC_CORES || task->pinned || task->core != me) {
+        return false;
+    }
+    if (core == me) {
+        return true;
+    }
+    for (uint32_t i = 0; i < self->outbox_count; i++) {
+        if (self->outbox[i] == task) {
+            self->outbox_core[i] = (uint8_t)core; // already queued, retarget
+            return true;
+        }
+    }
+    if (self->outbox_count >= ASYNC_HANDOFF_SIZE) {
+        return false;
+    }
+    self->outbox[self->outbox_count] = task;
+    self->outbox_core[self->outbox_count] = (uint8_t)core;
+    self->outbox_count++;
+    return true;
+}
+
+static void flush_outbox(CoreScheduler* self) {
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < self->outbox_count; i++) {
+        Task* task = self->outbox[i];
+        uint8_t core = self->outbox_core[i];
+        spsc_ring_t* q = &cores[core].inbox;
+        if (spsc_ring_space(q, 1) == 0) {
+            // Other core is backed up: the task keeps running here, retry next pass
+            self->outbox[kept] = task;
+            self->outbox_core[kept] = core;
+            kept++;
+            self->load.handoff_full++;
+            continue;
+        }
+        TaskList_Remove(&self->list, task);
+        task->core = core;
+        spsc_ring_push(q, &task);
+        self->load.migrated_out++;
+    }
+    self->outbox_count = kept;
+}
+
+// One pass on the calling core: adopt arriving tasks, run due ones, hand off migrations.
+// A migrated task restarts its period on the new core.
+uint32_t Multicore_Update(void) {
+    CoreScheduler* self = &cores[async_core_num()];
+    Task* task;
+    while (spsc_ring_pop(&self->inbox, &task)) {
+        TaskList_Add(&self->list, task);
+        self->load.migrated_in++;
+    }
+
+    async_time_t start = async_time_now();
+    uint32_t ran = Update(&self->list);
+    self->load.passes++;
+    if (ran) {
+        self->load.dispatched += ran;
+        self->load.busy_us += async_time_now() - start;
+    }
+
+    if (self->outbox_count) {
+        flush_outbox(self);
+    }
+    return ran;
+}
+
+void Multicore_Run(void) {
+    CoreScheduler* self = &cores[async_core_num()];
+    while (true) {
+        Multicore_Update();
+        scheduler_idle(&self->list);
+    }
+}
+
+const CoreLoad* Multicore_Load(uint32_t core) {
+    return core < ASYNC_CORES ? &cores[core].load : NULL;
+}
+
+#endif
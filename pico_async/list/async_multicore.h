@@ -0,0 +1,44 @@
+#ifndef ASYNC_MULTICORE_H
+#define ASYNC_MULTICORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "async_task.h"
+
+// Dual-core scheduler: each core runs its own TaskList. Tasks move between
+// cores through a lock-free single-producer/single-consumer ring (spsc_ring.h) per
+// core (with two cores the only producer for a core's queue is the other core).
+// Build with ASYNC_TASK_MULTICORE=1. All calls are for thread context, not ISRs.
+
+#define ASYNC_CORES (2)
+
+// Handoff queue depth per core (power of two)
+#ifndef ASYNC_HANDOFF_SIZE
+#define ASYNC_HANDOFF_SIZE (16)
+#endif
+
+#if ASYNC_HANDOFF_SIZE & (ASYNC_HANDOFF_SIZE - 1)
+#error "ASYNC_HANDOFF_SIZE must be a power of two"
+#endif
+
+// Per-core load counters, written only by the owning core
+typedef struct {
+    uint32_t passes;        // Multicore_Update() calls
+    uint32_t dispatched;    // Callbacks run
+    uint32_t migrated_in;   // Tasks received through the handoff queue
+    uint32_t migrated_out;  // Tasks handed to the other core
+    uint32_t handoff_full;  // Handoffs retried because the other queue was full
+    async_time_t busy_us;   // Time spent in passes that ran at least one callback
+} CoreLoad;
+
+// Host builds map threads to cores and provide this
+uint32_t async_core_num(void);
+
+void Multicore_Init(void);                          // call on core 0 before launching core 1
+bool Multicore_Add(Task* task, uint32_t core);      // from either core
+bool Multicore_Migrate(Task* task, uint32_t core);  // on the owning core, e.g. from the task's callback
+uint32_t Multicore_Update(void);                    // this core's Update() plus handoffs
+void Multicore_Run(void);                           // per-core main loop, never returns
+const CoreLoad* Multicore_Load(uint32_t core);
+
+#endif
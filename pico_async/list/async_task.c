@@ -0,0 +1,748 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#ifndef ASYNC_TASK_HOST
+#include "pico/stdlib.h"
+#endif
+#include "async_task.h"
+#include "async_alarm.h"
+
+// Initialize the task list
+void TaskList_Init(TaskList* list) {
+    list->head = NULL;
+    list->running = NULL;
+#if !ASYNC_TASK_USE_HEAP
+    list->cursor = NULL;
+#endif
+#if ASYNC_TASK_ORDER != TASK_ORDER_FIFO
+    list->ready_next = 0;
+    list->ready_count = 0;
+#endif
+#if ASYNC_TASK_PRIO_STATS
+    memset(list->prio_stats, 0, sizeof(list->prio_stats));
+#endif
+#if ASYNC_TASK_COALESCE
+    list->wakes = 0;
+    list->wakes_saved = 0;
+    list->instant_count = 0;
+#endif
+#if ASYNC_TASK_GOVERNOR
+    list->governor = (TaskGovernor){0};
+#endif
+#if ASYNC_PROFILE
+    TaskList_ProfileReset(list);
+#endif
+}
+
+#if ASYNC_ALARM
+// Arm the alarm for the deadline and wait for it, or for any other event. The
+// alarm ISR only wakes the core; the due tasks run in the next Update().
+void scheduler_sleep_until(async_time_t deadline) {
+    if (deadline == SCHEDULER_NO_DEADLINE) {
+        async_alarm_cancel();
+    } else {
+        async_alarm_arm(deadline);
+    }
+    async_alarm_wait();
+}
+// Host builds (see ../host and async_tasks/host) provide their own scheduler_sleep_until()
+#elif !defined(ASYNC_TASK_HOST)
+// Wait for the deadline or any event (interrupt, __sev() from an ISR or the other core)
+void scheduler_sleep_until(async_time_t deadline)
+{
+    if (deadline == SCHEDULER_NO_DEADLINE) {
+        __wfe();
+        return;
+    }
+    best_effort_wfe_or_timeout(from_us_since_boot(deadline));
+}
+#endif
+
+// Advance next_run_at by whole intervals from the scheduled time, not from
+// the time the task actually ran, so loop latency does not accumulate
+static void task_reschedule(Task* task, async_time_t current_time) {
+    if (task->interval == 0) {
+        task->next_run_at = current_time;
+        return;
+    }
+    if (async_time_before(current_time, task->next_run_at + task->interval)) {
+        task->next_run_at += task->interval;
+        return;
+    }
+    async_time_t periods = (current_time - task->next_run_at) / task->interval;
+    switch (task->catch_up) {
+    case CATCH_UP_BURST:
+        task->missed++;
+        task->next_run_at += task->interval;
+        break;
+    case CATCH_UP_ONCE:
+        task->missed += (uint32_t)periods;
+        task->next_run_at = current_time + task->interval;
+        break;
+    default:
+        task->missed += (uint32_t)periods;
+        task->next_run_at += (periods + 1) * task->interval;
+        break;
+    }
+}
+
+// Time by which a run should have started: rel_deadline (or one interval) after release
+static inline async_time_t task_abs_deadline(const Task* task) {
+    return task->next_run_at + (task->rel_deadline ? task->rel_deadline : task->interval);
+}
+
+#if ASYNC_TASK_PRIO_STATS
+// Record dispatch latency, measured right before the callback
+static void prio_stats_record(TaskList* list, const Task* task) {
+    async_time_t now = async_time_now();
+    uint8_t prio = task->priority < ASYNC_TASK_PRIORITIES ? task->priority : ASYNC_TASK_PRIORITIES - 1;
+    TaskPrioStats* stats = &list->prio_stats[prio];
+    async_time_t latency = async_time_reached(now, task->next_run_at) ? now - task->next_run_at : 0;
+    stats->runs++;
+    stats->total_latency += latency;
+    if (latency > stats->max_latency) {
+        stats->max_latency = latency;
+    }
+    if ((task->rel_deadline || task->interval) && async_time_before(task_abs_deadline(task), now)) {
+        stats->late++;
+    }
+}
+#define PRIO_STATS_RECORD(list, task) prio_stats_record((list), (task))
+#else
+#define PRIO_STATS_RECORD(list, task) ((void)0)
+#endif
+
+#if ASYNC_PROFILE
+// Profile entry of a task in this list; a task gets the next free entry on its
+// first run and is not profiled once the table is full
+static async_task_profile_t* profile_entry(TaskList* list, Task* task) {
+    if (task->profile_slot != 0 && list->profile[task->profile_slot - 1].task == task) {
+        return &list->profile[task->profile_slot - 1];
+    }
+    for (uint32_t i = 0; i < ASYNC_PROFILE_MAX_TASKS; i++) {
+        if (list->profile[i].task == NULL) {
+            list->profile[i].task = task;
+            task->profile_slot = (uint8_t)(i + 1);
+            return &list->profile[i];
+        }
+    }
+    return NULL;
+}
+
+void TaskList_ProfileReset(TaskList* list) {
+    memset(list->profile, 0, sizeof(list->profile));
+    list->loop = (async_loop_profile_t){0};
+    list->loop.since = async_time_now();
+}
+
+void TaskList_ProfileDump(TaskList* list) {
+    async_profile_print_header(&list->loop, async_time_now());
+    for (uint32_t i = 0; i < ASYNC_PROFILE_MAX_TASKS; i++) {
+        async_profile_print(&list->profile[i]);
+    }
+}
+#define PROFILE_PASS(list) ((list)->loop.passes++)
+#else
+#define PROFILE_PASS(list) ((void)0)
+#endif
+
+#if ASYNC_TASK_COALESCE
+// The first deadline instant a pass serves is the wake itself; every further
+// distinct instant would have needed a wake of its own without coalescing
+static void coalesce_note(TaskList* list, async_time_t due) {
+    for (uint32_t i = 0; i < list->instant_count; i++) {
+        if (list->instants[i] == due) {
+            return;
+        }
+    }
+    if (list->instant_count == 0) {
+        list->wakes++;
+    } else {
+        list->wakes_saved++;
+    }
+    if (list->instant_count < ASYNC_TASK_COALESCE_TRACK) {
+        list->instants[list->instant_count++] = due;
+    }
+}
+#define COALESCE_PASS(list) ((list)->instant_count = 0)
+#define COALESCE_NOTE(list, task) coalesce_note((list), (task)->next_run_at)
+#define TASK_WAKE_AT(task, at) ((at) + (task)->slack)
+#else
+#define COALESCE_PASS(list) ((void)0)
+#define COALESCE_NOTE(list, task) ((void)0)
+#define TASK_WAKE_AT(task, at) (at)
+#endif
+
+#if ASYNC_TASK_GOVERNOR
+// Feed the lateness of a due task into the lag estimate and decide whether it
+// is shed. Shed runs still sample the lag, so the governor releases even when
+// only sheddable tasks are left.
+static bool governor_shed(TaskList* list, Task* task) {
+    TaskGovernor* gov = &list->governor;
+    async_time_t now = async_time_now();
+    async_time_t late = async_time_reached(now, task->next_run_at) ? now - task->next_run_at : 0;
+#if ASYNC_TASK_COALESCE
+    late = late > task->slack ? late - task->slack : 0;
+#endif
+    if (late > gov->lag_max_us) {
+        gov->lag_max_us = late;
+    }
+    if (late >= gov->lag_us) {
+        gov->lag_us += (late - gov->lag_us) >> ASYNC_TASK_GOVERNOR_SHIFT;
+    } else {
+        gov->lag_us -= (gov->lag_us - late) >> ASYNC_TASK_GOVERNOR_SHIFT;
+    }
+
+    if (gov->lag_us > ASYNC_TASK_GOVERNOR_LAG_US) {
+        gov->over_at = now;
+        if (!gov->engaged) {
+            gov->engaged = true;
+            gov->engages++;
+        }
+    } else if (gov->engaged && gov->lag_us < ASYNC_TASK_GOVERNOR_LAG_US / 2 &&
+               now - gov->over_at >= ASYNC_TASK_GOVERNOR_HOLD_US) {
+        gov->engaged = false;
+        gov->releases++;
+    }
+    if (!gov->engaged) {
+        task->shed_count = 0;
+        return false;
+    }
+
+    switch (task->shed) {
+    case SHED_STRETCH:
+        if (task->shed_count++ == 0) {
+            return false;
+        }
+        if (task->shed_count >= ASYNC_TASK_GOVERNOR_STRETCH) {
+            task->shed_count = 0;
+        }
+        gov->stretched++;
+        return true;
+    case SHED_SKIP:
+        gov->skipped++;
+        return true;
+    default:
+        return false;
+    }
+}
+#define GOVERNOR_SHED(list, task) governor_shed((list), (task))
+#else
+#define GOVERNOR_SHED(list, task) (false)
+#endif
+
+// Run one callback, with the optional statistics around it. Returns false when
+// the governor shed the run; the task is rescheduled either way.
+static inline bool task_dispatch(TaskList* list, Task* task) {
+    (void)list; // only the optional statistics and the governor use it
+    COALESCE_NOTE(list, task);
+    if (GOVERNOR_SHED(list, task)) {
+        return false;
+    }
+    PRIO_STATS_RECORD(list, task);
+#if ASYNC_PROFILE
+    async_time_t due = task->next_run_at;
+    async_time_t period = task->rel_deadline ? task->rel_deadline : task->interval;
+    async_time_t start = async_time_now();
+#endif
+    task->callback(task);
+#if ASYNC_PROFILE
+    async_time_t end = async_time_now();
+    list->loop.busy_us += end - start;
+    async_task_profile_t* profile = profile_entry(list, task);
+    if (profile != NULL) {
+        async_profile_record(profile, start, end, due, period);
+    }
+#endif
+    return true;
+}
+
+#if ASYNC_TASK_ORDER != TASK_ORDER_FIFO
+
+static inline bool task_ranks_before(const Task* a, const Task* b) {
+#if ASYNC_TASK_ORDER == TASK_ORDER_PRIORITY
+    if (a->priority != b->priority) {
+        return a->priority < b->priority;
+    }
+#endif
+    return async_time_before(task_abs_deadline(a), task_abs_deadline(b));
+}
+
+// Insert a due task into this pass's ready array, keeping dispatch order.
+// Returns the task that did not fit (the new one or the evicted last one), or NULL.
+static Task* ready_insert(TaskList* list, Task* task) {
+    Task* dropped = NULL;
+    uint32_t n = list->ready_count;
+    if (n == ASYNC_TASK_READY_MAX) {
+        if (!task_ranks_before(task, list->ready[n - 1])) {
+            return task;
+        }
+        dropped = list->ready[--n];
+    } else {
+        list->ready_count++;
+    }
+    while (n > 0 && task_ranks_before(task, list->ready[n - 1])) {
+        list->ready[n] = list->ready[n - 1];
+        n--;
+    }
+    list->ready[n] = task;
+    return dropped;
+}
+
+// Tasks still waiting in this pass's ready array
+static Task** ready_find(TaskList* list, const Task* task) {
+    for (uint32_t i = list->ready_next; i < list->ready_count; i++) {
+        if (list->ready[i] == task) {
+            return &list->ready[i];
+        }
+    }
+    return NULL;
+}
+
+// End the pass early once it has used its time budget
+static inline bool pass_budget_spent(async_time_t pass_start) {
+#if ASYNC_TASK_PASS_BUDGET_US
+    return async_time_reached(async_time_now(), pass_start + ASYNC_TASK_PASS_BUDGET_US);
+#else
+    (void)pass_start;
+    return false;
+#endif
+}
+
+#endif
+
+#if ASYNC_TASK_USE_HEAP
+
+// Pairing heap keyed by deadline
+static inline int heap_before(const Task* a, const Task* b) {
+    return async_time_before(a->deadline, b->deadline);
+}
+
+// Link two heap roots; the later one becomes the first child of the earlier one
+static Task* heap_meld(Task* a, Task* b) {
+    if (a == NULL) {
+        return b;
+    }
+    if (b == NULL) {
+        return a;
+    }
+    if (heap_before(b, a)) {
+        Task* t = a;
+        a = b;
+        b = t;
+    }
+    b->prev = a;
+    b->next = a->child;
+    if (a->child != NULL) {
+        a->child->prev = b;
+    }
+    a->child = b;
+    return a;
+}
+
+// Standard two-pass merge of a sibling chain into a single heap
+static Task* heap_merge_pairs(Task* first) {
+    if (first == NULL) {
+        return NULL;
+    }
+
+    // Pass 1: meld pairs left to right, collecting results in reverse order
+    Task* pairs = NULL;
+    while (first != NULL) {
+        Task* a = first;
+        Task* b = a->next;
+        if (b == NULL) {
+            a->next = pairs;
+            pairs = a;
+            break;
+        }
+        first = b->next;
+        Task* m = heap_meld(a, b);
+        m->next = pairs;
+        pairs = m;
+    }
+
+    // Pass 2: meld the pairs right to left
+    Task* root = pairs;
+    pairs = pairs->next;
+    while (pairs != NULL) {
+        Task* n = pairs->next;
+        root = heap_meld(root, pairs);
+        pairs = n;
+    }
+    root->next = NULL;
+    root->prev = NULL;
+    return root;
+}
+
+static void heap_unlink(TaskList* list, Task* task) {
+    if (task == list->head) {
+        list->head = heap_merge_pairs(task->child);
+    } else {
+        // Cut the subtree out of its sibling chain, then merge its children back
+        if (task->prev->child == task) {
+            task->prev->child = task->next;
+        } else {
+            task->prev->next = task->next;
+        }
+        if (task->next != NULL) {
+            task->next->prev = task->prev;
+        }
+        list->head = heap_meld(list->head, heap_merge_pairs(task->child));
+    }
+    task->next = NULL;
+    task->prev = NULL;
+    task->child = NULL;
+}
+
+static inline void heap_insert(TaskList* list, Task* task) {
+    task->next = NULL;
+    task->prev = NULL;
+    task->child = NULL;
+    list->head = heap_meld(list->head, task);
+}
+
+static inline int heap_contains(TaskList* list, const Task* task) {
+#if ASYNC_TASK_ORDER != TASK_ORDER_FIFO
+    if (ready_find(list, task) != NULL) {
+        return 1; // taken out of the heap for this pass
+    }
+#endif
+    return task == list->head || task->prev != NULL || task == list->running;
+}
+
+// Put a task that has run back into the heap. A task that is still due
+// (interval 0, burst catch-up) runs again on the next tick, not in this pass.
+static void heap_requeue(TaskList* list, Task* task, async_time_t current_time) {
+    task_reschedule(task, current_time);
+    task->deadline = task->next_run_at;
+    if (async_time_reached(current_time, task->deadline)) {
+        task->deadline = current_time + 1;
+    }
+    heap_insert(list, task);
+}
+
+// Add a task to the active tasks heap
+void TaskList_Add(TaskList* list, Task* task) {
+    if (task == NULL || task->callback == NULL) {
+        return; // Invalid task
+    }
+    if (heap_contains(list, task)) {
+        return; // Already in list
+    }
+    task->last_run = async_time_now(); // Initialize last_run
+    task->next_run_at = task->last_run + task->interval;
+    task->deadline = task->next_run_at;
+    heap_insert(list, task);
+}
+
+// Remove a task from the active tasks heap
+void TaskList_Remove(TaskList* list, Task* task) {
+    if (task == NULL) {
+        return;
+    }
+    if (task == list->running) {
+        list->running = NULL; // Removed itself from inside its callback
+        return;
+    }
+#if ASYNC_TASK_ORDER != TASK_ORDER_FIFO
+    Task** slot = ready_find(list, task);
+    if (slot != NULL) {
+        *slot = NULL; // Due in this pass but not run yet
+        return;
+    }
+#endif
+    if (heap_contains(list, task)) {
+        heap_unlink(list, task);
+    }
+}
+
+#if ASYNC_TASK_ORDER == TASK_ORDER_FIFO
+
+// Run tasks that are due - only the heap root is checked while nothing is due
+uint32_t Update(TaskList* list) {
+    async_time_t current_time = async_time_now();
+    uint32_t ran = 0;
+    PROFILE_PASS(list);
+    COALESCE_PASS(list);
+
+    while (list->head != NULL && async_time_reached(current_time, list->head->deadline)) {
+        Task* current = list->head;
+        heap_unlink(list, current);
+        current->last_run = current_time;
+        list->running = current;
+        if (current->callback != NULL) {
+            ran += task_dispatch(list, current);
+        }
+        // Reschedule unless the callback removed the task
+        if (list->running == current) {
+            list->running = NULL;
+            heap_requeue(list, current, current_time);
+        }
+    }
+    return ran;
+}
+
+#else
+
+// Take every due task out of the heap, then run them in priority/deadline order
+uint32_t Update(TaskList* list) {
+    async_time_t current_time = async_time_now();
+    uint32_t ran = 0;
+    PROFILE_PASS(list);
+    COALESCE_PASS(list);
+
+    // Tasks that do not fit in the ready array go back still due, for a later pass
+    Task* overflow = NULL;
+    list->ready_next = 0;
+    list->ready_count = 0;
+    while (list->head != NULL && async_time_reached(current_time, list->head->deadline)) {
+        Task* current = list->head;
+        heap_unlink(list, current);
+        Task* dropped = ready_insert(list, current);
+        if (dropped != NULL) {
+            dropped->next = overflow;
+            overflow = dropped;
+        }
+    }
+    while (overflow != NULL) {
+        Task* next = overflow->next;
+        heap_insert(list, overflow);
+        overflow = next;
+    }
+
+    while (list->ready_next < list->ready_count) {
+        Task* current = list->ready[list->ready_next++];
+        if (current == NULL) {
+            continue; // Removed by an earlier callback
+        }
+        current->last_run = current_time;
+        list->running = current;
+        if (current->callback != NULL) {
+            ran += task_dispatch(list, current);
+        }
+        if (list->running == current) {
+            list->running = NULL;
+            heap_requeue(list, current, current_time);
+        }
+        if (pass_budget_spent(current_time)) {
+            break;
+        }
+    }
+
+    // Pass ended early: the rest are still due and are ranked again next pass
+    while (list->ready_next < list->ready_count) {
+        Task* current = list->ready[list->ready_next++];
+        if (current != NULL) {
+            heap_insert(list, current);
+        }
+    }
+    list->ready_next = 0;
+    list->ready_count = 0;
+    return ran;
+}
+
+#endif
+
+// Lower *wake to the earliest wake time of a running task in a subtree.
+// Children never have an earlier deadline than their parent, so a node whose
+// deadline is not before *wake is skipped with its whole subtree, and without
+// coalescing a running task ends its path. Stopped tasks (no callback) stay
+// in the heap but never wake the loop, so the walk looks through them.
+static void heap_min_wake(const Task* node, bool* found, async_time_t* wake) {
+    for (; node != NULL; node = node->next) {
+        if (*found && !async_time_before(node->deadline, *wake)) {
+            continue;
+        }
+        if (node->callback != NULL) {
+            async_time_t at = TASK_WAKE_AT(node, node->deadline);
+            if (!*found || async_time_before(at, *wake)) {
+                *wake = at;
+                *found = true;
+            }
+#if !ASYNC_TASK_COALESCE
+            continue;
+#endif
+        }
+        heap_min_wake(node->child, found, wake);
+    }
+}
+
+// Earliest deadline of a running task: the heap root unless it is stopped;
+// with coalescing, the earliest deadline + slack, which is never later than
+// the first running task's
+bool scheduler_next_deadline(TaskList* list, async_time_t* deadline) {
+    bool found = false;
+    heap_min_wake(list->head, &found, deadline);
+    return found;
+}
+
+#else
+
+// Add a task to the active tasks list. A task added from a callback is put in
+// front of the pass cursor, so it first runs in the next Update().
+void TaskList_Add(TaskList* list, Task* task) {
+    if (task == NULL || task->callback == NULL) {
+        return; // Invalid task
+    }
+    if (task->listed) {
+        return; // Already in list
+    }
+
+    // Add to the beginning of the list
+    task->prev = NULL;
+    task->next = list->head;
+    if (list->head != NULL) {
+        list->head->prev = task;
+    }
+    list->head = task;
+    task->listed = true;
+    task->last_run = async_time_now(); // Initialize last_run
+    task->next_run_at = task->last_run + task->interval;
+}
+
+// Remove a task from the active tasks list, also from inside any callback
+void TaskList_Remove(TaskList* list, Task* task) {
+    if (task == NULL || !task->listed) {
+        return;
+    }
+    if (task->prev == NULL && list->head != task) {
+        return; // In another list
+    }
+#if ASYNC_TASK_ORDER != TASK_ORDER_FIFO
+    Task** slot = ready_find(list, task);
+    if (slot != NULL) {
+        *slot = NULL; // Due in this pass but not run yet
+    }
+#endif
+    if (task == list->running) {
+        list->running = NULL; // Removed itself: Update() must not reschedule it
+    }
+    if (task == list->cursor) {
+        list->cursor = task->next; // Update() was about to visit it
+    }
+
+    if (task->prev != NULL) {
+        task->prev->next = task->next;
+    } else {
+        list->head = task->next;
+    }
+    if (task->next != NULL) {
+        task->next->prev = task->prev;
+    }
+    task->next = NULL;
+    task->prev = NULL;
+    task->listed = false;
+}
+
+// Run one due task; it is rescheduled unless its callback removed it
+static inline uint32_t list_run(TaskList* list, Task* task, async_time_t current_time) {
+    task->last_run = current_time;
+    list->running = task;
+    uint32_t ran = task_dispatch(list, task);
+    if (list->running == task) {
+        list->running = NULL;
+        task_reschedule(task, current_time);
+    }
+    return ran;
+}
+
+#if ASYNC_TASK_ORDER == TASK_ORDER_FIFO
+
+// Update all active tasks - call this every 1ms (or as fast as possible from loop)
+uint32_t Update(TaskList* list) {
+    async_time_t current_time = async_time_now();
+    uint32_t ran = 0;
+    PROFILE_PASS(list);
+    COALESCE_PASS(list);
+
+    // The cursor is read back after each callback, which may have removed
+    // the task it ran or the one after it
+    Task* current = list->head;
+    while (current != NULL) {
+        list->cursor = current->next;
+        // Skip tasks without callback
+        if (current->callback != NULL) {
+            // Check if it's time to run the task
+            if (async_time_reached(current_time, current->next_run_at)) {
+                ran += list_run(list, current, current_time);
+            }
+        }
+        current = list->cursor;
+    }
+    list->cursor = NULL;
+    return ran;
+}
+
+#else
+
+// Rank the due tasks, then run them in priority/deadline order
+uint32_t Update(TaskList* list) {
+    async_time_t current_time = async_time_now();
+    uint32_t ran = 0;
+    PROFILE_PASS(list);
+    COALESCE_PASS(list);
+
+    // Tasks that do not fit in the ready array stay due for a later pass
+    list->ready_next = 0;
+    list->ready_count = 0;
+    for (Task* current = list->head; current != NULL; current = current->next) {
+        if (current->callback != NULL && async_time_reached(current_time, current->next_run_at)) {
+            ready_insert(list, current);
+        }
+    }
+
+    while (list->ready_next < list->ready_count) {
+        Task* current = list->ready[list->ready_next++];
+        if (current == NULL || current->callback == NULL) {
+            continue; // Removed or stopped by an earlier callback
+        }
+        ran += list_run(list, current, current_time);
+        if (pass_budget_spent(current_time)) {
+            break; // The rest are still due and are ranked again next pass
+        }
+    }
+    list->ready_next = 0;
+    list->ready_count = 0;
+    return ran;
+}
+
+#endif
+
+// Earliest deadline of all active tasks
+bool scheduler_next_deadline(TaskList* list, async_time_t* deadline) {
+    bool found = false;
+    for (Task* current = list->head; current != NULL; current = current->next) {
+        if (current->callback == NULL) {
+            continue;
+        }
+        async_time_t wake = TASK_WAKE_AT(current, current->next_run_at);
+        if (!found || async_time_before(wake, *deadline)) {
+            *deadline = wake;
+            found = true;
+        }
+    }
+    return found;
+}
+
+#endif
+
+// Sleep until the next deadline; returns early if an interrupt or event arrives
+void scheduler_idle(TaskList* list) {
+    async_time_t deadline = 0;
+    if (!scheduler_next_deadline(list, &deadline)) {
+        scheduler_sleep_until(SCHEDULER_NO_DEADLINE);
+        return;
+    }
+    if (async_time_before(async_time_now(), deadline)) {
+        scheduler_sleep_until(deadline);
+    }
+}
+
+// Main loop replacement: run due tasks, then idle until the next one
+void scheduler_run(TaskList* list) {
+    while (true) {
+        Update(list);
+        scheduler_idle(list);
+    }
+}
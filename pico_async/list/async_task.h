@@ -0,0 +1,224 @@
+#ifndef ASYNC_TASK_H
+#define ASYNC_TASK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "async_time.h"
+#include "async_profile.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Scheduler mode (set from CMake with target_compile_definitions):
+//  0 - doubly-linked list, Update() checks every task on every call (default).
+//      Add/Remove are O(1).
+//  1 - deadline heap, Update() only looks at tasks that are due.
+//      Add/Remove/reschedule are O(log n).
+// In both modes Task structs must be zero-initialized (static/global or "= {0}")
+// before the first TaskList_Add(), and callbacks may add or remove any task.
+#ifndef ASYNC_TASK_USE_HEAP
+#define ASYNC_TASK_USE_HEAP 0
+#endif
+
+// Dual-core mode (async_multicore.c): one TaskList per core plus a handoff queue
+#ifndef ASYNC_TASK_MULTICORE
+#define ASYNC_TASK_MULTICORE 0
+#endif
+
+// Order in which tasks that are due in the same Update() pass are dispatched
+#define TASK_ORDER_FIFO     (0)     // list order (deadline order in heap mode)
+#define TASK_ORDER_PRIORITY (1)     // Task.priority (0 = most urgent), then earliest deadline
+#define TASK_ORDER_EDF      (2)     // earliest deadline first (see Task.rel_deadline)
+#ifndef ASYNC_TASK_ORDER
+#define ASYNC_TASK_ORDER TASK_ORDER_FIFO
+#endif
+
+// Due tasks ordered per pass; more than this wait for a later pass (best ones first)
+#ifndef ASYNC_TASK_READY_MAX
+#define ASYNC_TASK_READY_MAX (16)
+#endif
+
+// With an ordered dispatch, end a pass once it has run this long (0 = never) so an
+// urgent task that became due meanwhile is dispatched before the rest of the pass
+#ifndef ASYNC_TASK_PASS_BUDGET_US
+#define ASYNC_TASK_PASS_BUDGET_US (0)
+#endif
+
+// Priority classes and per-class dispatch latency statistics (TaskList.prio_stats)
+#ifndef ASYNC_TASK_PRIORITIES
+#define ASYNC_TASK_PRIORITIES (4)
+#endif
+#ifndef ASYNC_TASK_PRIO_STATS
+#define ASYNC_TASK_PRIO_STATS 0
+#endif
+
+// Wakeup coalescing: a task may start up to Task.slack after next_run_at, and
+// scheduler_idle() sleeps until the earliest next_run_at + slack so that every
+// task due by then shares one wake. TaskList.wakes_saved counts the result.
+#ifndef ASYNC_TASK_COALESCE
+#define ASYNC_TASK_COALESCE 0
+#endif
+// Distinct deadline instants a pass remembers for wakes_saved (more count as distinct)
+#ifndef ASYNC_TASK_COALESCE_TRACK
+#define ASYNC_TASK_COALESCE_TRACK (8)
+#endif
+
+// Overload governor: tracks the smoothed dispatch lag of the list and, while it is
+// above ASYNC_TASK_GOVERNOR_LAG_US, sheds tasks whose Task.shed allows it until
+// the lag is back under half the threshold (decisions counted in TaskList.governor)
+#ifndef ASYNC_TASK_GOVERNOR
+#define ASYNC_TASK_GOVERNOR 0
+#endif
+#ifndef ASYNC_TASK_GOVERNOR_LAG_US
+#define ASYNC_TASK_GOVERNOR_LAG_US (2000)
+#endif
+// Lag smoothing: each dispatch moves the estimate 1/2^SHIFT of the way to its lateness
+#ifndef ASYNC_TASK_GOVERNOR_SHIFT
+#define ASYNC_TASK_GOVERNOR_SHIFT (3)
+#endif
+// Shedding hides the overload it reacts to, so the governor stays engaged until
+// the lag has stayed under the threshold this long (otherwise it flaps every few passes)
+#ifndef ASYNC_TASK_GOVERNOR_HOLD_US
+#define ASYNC_TASK_GOVERNOR_HOLD_US (500000)
+#endif
+// A SHED_STRETCH task runs one period in this many while the governor is engaged
+#ifndef ASYNC_TASK_GOVERNOR_STRETCH
+#define ASYNC_TASK_GOVERNOR_STRETCH (4)
+#endif
+
+// Profiler (ASYNC_PROFILE=1, see async_profile.h): per-task entries in TaskList.profile
+#ifndef ASYNC_PROFILE_MAX_TASKS
+#define ASYNC_PROFILE_MAX_TASKS (16)
+#endif
+
+// Forward declare Task so typedefs can use it
+typedef struct Task Task;
+
+// Callback type for tasks (pointer to function that gets a Task pointer)
+typedef void (*TaskCallback)(Task *task);
+
+// What a periodic task does when it runs a whole interval (or more) late.
+// On-time runs are always anchored to the original phase (next += interval).
+typedef enum {
+    CATCH_UP_SKIP = 0,      // Run once, drop the missed periods, keep the phase (default)
+    CATCH_UP_ONCE,          // Run once and restart the period from now
+    CATCH_UP_BURST,         // Run once per missed period, one run per Update(), until caught up
+} TaskCatchUp;
+
+// What the overload governor may do with a task while the loop is behind
+typedef enum {
+    SHED_NEVER = 0,         // Critical: always runs at its own cadence (default)
+    SHED_STRETCH,           // Runs one period in ASYNC_TASK_GOVERNOR_STRETCH
+    SHED_SKIP,              // Does not run at all
+} TaskShed;
+
+// Task structure with linked list pointer
+typedef struct Task {
+    struct Task* next;      // Next task in the list (next sibling in heap mode)
+    struct Task* prev;      // Previous task (heap: previous sibling, or parent for a first child)
+#if ASYNC_TASK_USE_HEAP
+    struct Task* child;     // First child in the deadline heap
+    async_time_t deadline;  // Heap key: next_run_at, or the next tick if already due
+#else
+    bool listed;            // In a TaskList: makes the duplicate check of TaskList_Add() O(1)
+#endif
+    async_time_t next_run_at; // Next scheduled execution time in microseconds
+    async_time_t last_run;  // Last execution time in microseconds
+    async_time_t interval;  // Interval between executions in microseconds (use ASYNC_MS())
+    uint32_t missed;        // Deadlines missed by a whole interval or more
+    TaskCallback callback; // Function to call (NULL = not active)
+    async_time_t rel_deadline; // Deadline after next_run_at for EDF/lateness (0 = interval)
+    uint8_t catch_up;       // TaskCatchUp policy
+    uint8_t priority;       // 0 = most urgent, up to ASYNC_TASK_PRIORITIES - 1
+#if ASYNC_TASK_COALESCE
+    async_time_t slack;     // How late the task may start to share another task's wake (0 = exact)
+#endif
+#if ASYNC_TASK_GOVERNOR
+    uint8_t shed;           // TaskShed policy under overload
+    uint8_t shed_count;     // Periods since the last stretched run
+#endif
+#if ASYNC_PROFILE
+    uint8_t profile_slot;   // 1 + index in TaskList.profile, 0 = not assigned yet
+#endif
+#if ASYNC_TASK_MULTICORE
+    uint8_t core;           // Core whose TaskList owns the task
+    bool pinned;            // Multicore_Migrate() refuses pinned tasks
+#endif
+} Task;
+
+// Dispatch latency of one priority class: time from next_run_at to the callback
+typedef struct {
+    uint32_t runs;
+    uint32_t late;          // runs that started after the task's deadline
+    async_time_t total_latency;
+    async_time_t max_latency;
+} TaskPrioStats;
+
+// Overload governor state and decisions
+typedef struct {
+    async_time_t lag_us;    // Smoothed dispatch lateness (beyond slack) of due tasks
+    async_time_t lag_max_us; // Largest single lateness seen
+    async_time_t over_at;   // Last time the lag was over ASYNC_TASK_GOVERNOR_LAG_US
+    bool engaged;           // Shedding is active
+    uint32_t engages;       // Times the lag crossed ASYNC_TASK_GOVERNOR_LAG_US
+    uint32_t releases;      // Times it fell back under half of it for the hold time
+    uint32_t stretched;     // Runs of SHED_STRETCH tasks dropped
+    uint32_t skipped;       // Runs of SHED_SKIP tasks dropped
+} TaskGovernor;
+
+// Active tasks list (linked list, or pairing heap with the earliest deadline at head)
+typedef struct {
+    Task* head;
+    Task* running;          // Task whose callback is executing (NULL if it removed itself)
+#if !ASYNC_TASK_USE_HEAP
+    Task* cursor;           // Next task Update() visits; TaskList_Remove() moves it past a removed task
+#endif
+#if ASYNC_TASK_ORDER != TASK_ORDER_FIFO
+    Task* ready[ASYNC_TASK_READY_MAX]; // Due tasks of the current pass, in dispatch order
+    uint8_t ready_next;
+    uint8_t ready_count;
+#endif
+#if ASYNC_TASK_PRIO_STATS
+    TaskPrioStats prio_stats[ASYNC_TASK_PRIORITIES];
+#endif
+#if ASYNC_TASK_COALESCE
+    uint32_t wakes;         // Passes that ran at least one task
+    uint32_t wakes_saved;   // Deadline instants served by a pass woken for an earlier one
+    async_time_t instants[ASYNC_TASK_COALESCE_TRACK]; // Deadlines served by the current pass
+    uint8_t instant_count;
+#endif
+#if ASYNC_TASK_GOVERNOR
+    TaskGovernor governor;
+#endif
+#if ASYNC_PROFILE
+    async_task_profile_t profile[ASYNC_PROFILE_MAX_TASKS];
+    async_loop_profile_t loop;
+#endif
+} TaskList;
+
+// Deadline for scheduler_sleep_until(): no task is pending, wait for an interrupt or __sev()
+#define SCHEDULER_NO_DEADLINE (UINT64_MAX)
+
+// Global function declarations
+void TaskList_Init(TaskList* list);
+void TaskList_Add(TaskList* list, Task* task);
+void TaskList_Remove(TaskList* list, Task* task);
+uint32_t Update(TaskList* list);    // returns the number of callbacks that ran
+
+#if ASYNC_PROFILE
+void TaskList_ProfileReset(TaskList* list);  // clear all entries and start a new window
+void TaskList_ProfileDump(TaskList* list);   // print the table with printf()
+#endif
+
+// Tickless idle: sleep until the earliest task deadline instead of polling
+bool scheduler_next_deadline(TaskList* list, async_time_t* deadline);
+void scheduler_sleep_until(async_time_t deadline);
+void scheduler_idle(TaskList* list);
+void scheduler_run(TaskList* list);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
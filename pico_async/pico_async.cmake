@@ -0,0 +1,94 @@
+# Task scheduler library with compile-time policies, for firmware and host builds.
+#
+#   pico_async_add_library(<name>
+#       STORAGE list|pool           # list: caller-owned Task structs on a TaskList (list/)
+#                                   # pool: fixed Task pool, task_add()/task_delete() (pool/)
+#       [QUEUE <queue>]             # list: scan (default) or heap
+#                                   # pool: scan (default), soa or wheel
+#       [ORDER fifo|priority|edf]   # dispatch order of due tasks, default fifo
+#       [TIME device|host]          # Pico SDK timer or host clock, default device with the SDK
+#       [ALARM]                     # wake on a dedicated timer alarm (async_alarm.h)
+#       [DEFINITIONS <def>...])     # further scheduler options, e.g. MAX_TASKS=64
+#
+# <name> is an INTERFACE library like the SDK's own: link it and the scheduler
+# sources are compiled into the target with its flags. Every header the
+# storage needs (async_time.h, async_profile.h, ...) is on the include path.
+
+set(PICO_ASYNC_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+function(pico_async_add_library name)
+    cmake_parse_arguments(ASYNC "ALARM" "STORAGE;QUEUE;ORDER;TIME" "DEFINITIONS" ${ARGN})
+
+    if(NOT ASYNC_QUEUE)
+        set(ASYNC_QUEUE scan)
+    endif()
+    if(NOT ASYNC_ORDER)
+        set(ASYNC_ORDER fifo)
+    endif()
+    if(NOT ASYNC_TIME)
+        if(COMMAND pico_sdk_init)
+            set(ASYNC_TIME device)
+        else()
+            set(ASYNC_TIME host)
+        endif()
+    endif()
+
+    set(dir ${PICO_ASYNC_DIR}/${ASYNC_STORAGE})
+    set(defs)
+    if(ASYNC_STORAGE STREQUAL "list")
+        set(sources ${dir}/async_task.c ${dir}/async_multicore.c)
+        if(ASYNC_QUEUE STREQUAL "scan")
+            list(APPEND defs ASYNC_TASK_USE_HEAP=0)
+        elseif(ASYNC_QUEUE STREQUAL "heap")
+            list(APPEND defs ASYNC_TASK_USE_HEAP=1)
+        else()
+            message(FATAL_ERROR "pico_async ${name}: list storage has no '${ASYNC_QUEUE}' queue (scan, heap)")
+        endif()
+    elseif(ASYNC_STORAGE STREQUAL "pool")
+        set(sources ${dir}/async_task.c ${dir}/timer_wheel.c)
+        if(ASYNC_QUEUE STREQUAL "scan")
+            list(APPEND defs ASYNC_TASK_USE_WHEEL=0 ASYNC_TASK_USE_SOA=0)
+        elseif(ASYNC_QUEUE STREQUAL "soa")
+            list(APPEND defs ASYNC_TASK_USE_WHEEL=0 ASYNC_TASK_USE_SOA=1)
+        elseif(ASYNC_QUEUE STREQUAL "wheel")
+            list(APPEND defs ASYNC_TASK_USE_WHEEL=1)
+        else()
+            message(FATAL_ERROR "pico_async ${name}: pool storage has no '${ASYNC_QUEUE}' queue (scan, soa, wheel)")
+        endif()
+    else()
+        message(FATAL_ERROR "pico_async ${name}: STORAGE must be list or pool")
+    endif()
+
+    if(ASYNC_ORDER STREQUAL "fifo")
+        list(APPEND defs ASYNC_TASK_ORDER=0)
+    elseif(ASYNC_ORDER STREQUAL "priority")
+        list(APPEND defs ASYNC_TASK_ORDER=1)
+    elseif(ASYNC_ORDER STREQUAL "edf")
+        list(APPEND defs ASYNC_TASK_ORDER=2)
+    else()
+        message(FATAL_ERROR "pico_async ${name}: ORDER must be fifo, priority or edf")
+    endif()
+
+    if(ASYNC_ALARM)
+        list(APPEND sources ${PICO_ASYNC_DIR}/async_alarm.c)
+        list(APPEND defs ASYNC_ALARM=1)
+    endif()
+
+    add_library(${name} INTERFACE)
+    target_sources(${name} INTERFACE ${sources})
+    target_include_directories(${name} INTERFACE ${dir} ${PICO_ASYNC_DIR})
+    target_compile_definitions(${name} INTERFACE ${defs} ${ASYNC_DEFINITIONS})
+
+    if(ASYNC_TIME STREQUAL "host")
+        # The host program provides async_time_now() and scheduler_sleep_until()
+        target_compile_definitions(${name} INTERFACE ASYNC_TIME_HOST ASYNC_TASK_HOST)
+        if(ASYNC_ALARM)
+            find_package(Threads REQUIRED)
+            target_link_libraries(${name} INTERFACE Threads::Threads)
+        endif()
+    elseif(ASYNC_TIME STREQUAL "device")
+        target_link_libraries(${name} INTERFACE pico_stdlib hardware_timer hardware_sync)
+    else()
+        message(FATAL_ERROR "pico_async ${name}: TIME must be device or host")
+    endif()
+endfunction()
@@ -0,0 +1,125 @@
+#ifndef ASYNC_CORO_H
+#define ASYNC_CORO_H
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "async_task.h"
+#ifndef ASYNC_TIME_HOST
+#include "hardware/sync.h"
+#endif
+
+// Stackless coroutines for pool tasks (protothread style).
+//
+// A coroutine is an ordinary task callback whose body sits between
+// CORO_BEGIN() and CORO_END(). An await returns from the callback and the
+// next run resumes right after it, so a long sequence can interleave with
+// other tasks without a stack of its own. The only state kept is
+// Task.coro_line.
+//
+//   static void bringup(Task *task)
+//   {
+//       CORO_BEGIN(task);
+//       sensor_reset();
+//       await_ms(task, 10);
+//       await_flag(task, sensor_ready());
+//       CORO_END(task);
+//   }
+//
+// Rules:
+//  - locals do not survive an await; keep state in the task (user data or a
+//    struct with Task as first member)
+//  - at most one await per source line (the line number is the resume point)
+//  - no awaits inside a switch statement of the coroutine body
+//  - CORO_END() deletes the task: its slot goes back to the pool, so nothing
+//    may use the Task pointer afterwards (a task_handle() taken earlier goes
+//    stale, which is how others can tell the coroutine has finished)
+
+// How often an await_flag() re-checks its condition
+#ifndef CORO_POLL_US
+#define CORO_POLL_US (1000)
+#endif
+
+#define CORO_BEGIN(task)    switch ((task)->coro_line) { case 0:
+
+#define CORO_END(task)      } (task)->coro_line = 0; task_delete(task); return
+
+// Let other tasks run; resume on the task's next scheduled run
+#define CORO_YIELD(task) \
+    do { (task)->coro_line = __LINE__; return; case __LINE__:; } while (0)
+
+// Start over from CORO_BEGIN() on the next run
+#define CORO_RESTART(task)  do { (task)->coro_line = 0; return; } while (0)
+
+// Resume after at least ms milliseconds
+#define await_ms(task, ms) \
+    do { \
+        task_sleep_until((task), async_time_now() + ASYNC_MS(ms)); \
+        CORO_YIELD(task); \
+    } while (0)
+
+// Resume once cond is true, checking it every CORO_POLL_US
+#define await_flag(task, cond) \
+    do { \
+        (task)->coro_line = __LINE__; case __LINE__: \
+        if (!(cond)) { \
+            task_sleep_until((task), async_time_now() + CORO_POLL_US); \
+            return; \
+        } \
+    } while (0)
+
+// One-shot event set from an ISR, the other core or another task. At most
+// one task awaits an event at a time.
+typedef struct {
+    atomic_bool set;
+    Task *_Atomic waiter;   // parked in await_event(), signaled by async_event_set()
+} async_event_t;
+
+static inline void async_event_set(async_event_t *ev)
+{
+    // Sequentially consistent, paired with async_event_wait(): either the
+    // waiter sees the flag or this sees the waiter
+    atomic_store(&ev->set, true);
+    Task *waiter = atomic_load(&ev->waiter);
+    if (waiter)
+        task_signal(waiter);
+#ifndef ASYNC_TIME_HOST
+    else
+        __sev(); // end a tickless sleep early
+#endif
+}
+
+// Consume the event; true if it was set
+static inline bool async_event_take(async_event_t *ev)
+{
+    return atomic_exchange(&ev->set, false);
+}
+
+// One check of await_event(). An event that is already set is taken without
+// touching the schedule. Otherwise the task is parked with task_wait_signal()
+// until async_event_set() signals it, and once it has the event it is back
+// on its timer (task_wait_timer()).
+static inline bool async_event_wait(async_event_t *ev, Task *task)
+{
+    if (atomic_load(&ev->waiter) != task)
+    {
+        if (async_event_take(ev))
+            return true;
+        atomic_store(&ev->waiter, task);
+        task_wait_signal(task);
+    }
+    if (!async_event_take(ev))
+        return false;           // parked, or woken by someone else's signal
+    atomic_store(&ev->waiter, NULL);
+    task_wait_timer(task);      // also drops a signal raised since this run started
+    return true;
+}
+
+// Resume once ev is set, consuming it; no polling in between
+#define await_event(task, ev) \
+    do { \
+        (task)->coro_line = __LINE__; case __LINE__: \
+        if (!async_event_wait((ev), (task))) \
+            return; \
+    } while (0)
+
+#endif
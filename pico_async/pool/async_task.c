@@ -0,0 +1,821 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#ifndef ASYNC_TASK_HOST
+#include "pico/stdlib.h"
+#endif
+#include "async_task.h"
+#include "async_alarm.h"
+#if ASYNC_TASK_USE_WHEEL
+#include "timer_wheel.h"
+#endif
+#if ASYNC_TASK_USE_SOA && !ASYNC_TASK_USE_WHEEL
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+#endif
+
+static Task all_tasks[MAX_TASKS] = {0};
+
+// Far enough ahead that a signal-driven task never comes due on its own
+#define TASK_PARKED (ASYNC_SEC(1) << 32)
+
+// Advance next_run_at by whole intervals from the scheduled time, not from
+// the time the task actually ran, so loop latency does not accumulate
+static void task_reschedule(Task *pt, async_time_t tm)
+{
+    if (pt->on_signal)
+    {
+        pt->next_run_at = tm + TASK_PARKED; // until the next task_signal()
+        return;
+    }
+    if (pt->interval == 0)
+    {
+        pt->next_run_at = tm;
+        return;
+    }
+    if (async_time_before(tm, pt->next_run_at + pt->interval))
+    {
+        pt->next_run_at += pt->interval;
+        return;
+    }
+    async_time_t periods = (tm - pt->next_run_at) / pt->interval;
+    switch (pt->catch_up)
+    {
+    case CATCH_UP_BURST:
+        pt->missed++;
+        pt->next_run_at += pt->interval;
+        break;
+    case CATCH_UP_ONCE:
+        pt->missed += (uint32_t)periods;
+        pt->next_run_at = tm + pt->interval;
+        break;
+    default:
+        pt->missed += (uint32_t)periods;
+        pt->next_run_at += (periods + 1) * pt->interval;
+        break;
+    }
+}
+
+// Time by which a run should have started: rel_deadline (or one interval) after release
+static inline async_time_t task_abs_deadline(const Task *pt)
+{
+    return pt->next_run_at + (pt->rel_deadline ? pt->rel_deadline : pt->interval);
+}
+
+#if ASYNC_TASK_PRIO_STATS
+static task_prio_stats_t prio_stats[ASYNC_TASK_PRIORITIES];
+
+// Record dispatch latency, measured right before the callback
+static void prio_stats_record(const Task *pt)
+{
+    async_time_t now = async_time_now();
+    task_prio_stats_t *stats = &prio_stats[pt->priority < ASYNC_TASK_PRIORITIES ? pt->priority : ASYNC_TASK_PRIORITIES - 1];
+    async_time_t latency = async_time_reached(now, pt->next_run_at) ? now - pt->next_run_at : 0;
+    stats->runs++;
+    stats->total_latency += latency;
+    if (latency > stats->max_latency)
+        stats->max_latency = latency;
+    if ((pt->rel_deadline || pt->interval) && async_time_before(task_abs_deadline(pt), now))
+        stats->late++;
+}
+
+const task_prio_stats_t *task_prio_stats(uint8_t priority)
+{
+    return priority < ASYNC_TASK_PRIORITIES ? &prio_stats[priority] : NULL;
+}
+#define PRIO_STATS_RECORD(pt) prio_stats_record(pt)
+#else
+#define PRIO_STATS_RECORD(pt) ((void)0)
+#endif
+
+#if ASYNC_PROFILE
+// One entry per pool slot; cleared when the slot is handed out again
+static async_task_profile_t profile_table[MAX_TASKS];
+static async_loop_profile_t loop_profile;
+
+static void profile_record(const Task *pt, async_time_t start, async_time_t due, async_time_t period)
+{
+    async_time_t end = async_time_now();
+    async_task_profile_t *entry = &profile_table[pt - all_tasks];
+    loop_profile.busy_us += end - start;
+    entry->task = pt;
+    async_profile_record(entry, start, end, due, period);
+}
+
+void task_profile_reset()
+{
+    for (uint i=0; i<MAX_TASKS; i++)
+        profile_table[i] = (async_task_profile_t){0};
+    loop_profile = (async_loop_profile_t){0};
+    loop_profile.since = async_time_now();
+}
+
+void task_profile_dump()
+{
+    async_profile_print_header(&loop_profile, async_time_now());
+    for (uint i=0; i<MAX_TASKS; i++)
+        async_profile_print(&profile_table[i]);
+}
+
+const async_task_profile_t *task_profile(const Task *task)
+{
+    if (task < all_tasks || task >= all_tasks + MAX_TASKS)
+        return NULL;
+    return &profile_table[task - all_tasks];
+}
+
+// Due time and period are taken before the task is re-armed
+#define PROFILE_BEGIN(pt) \
+    async_time_t prof_due = (pt)->next_run_at; \
+    async_time_t prof_period = (pt)->rel_deadline ? (pt)->rel_deadline : (pt)->interval; \
+    async_time_t prof_start = async_time_now()
+#define PROFILE_END(pt)     profile_record((pt), prof_start, prof_due, prof_period)
+#define PROFILE_PASS()      (loop_profile.passes++)
+#define PROFILE_CLEAR(pt)   (profile_table[(pt) - all_tasks] = (async_task_profile_t){0})
+#else
+#define PROFILE_BEGIN(pt)   ((void)0)
+#define PROFILE_END(pt)     ((void)0)
+#define PROFILE_PASS()      ((void)0)
+#define PROFILE_CLEAR(pt)   ((void)0)
+#endif
+
+#if ASYNC_TASK_ORDER != TASK_ORDER_FIFO
+// Due tasks of the current pass, in dispatch order. Every task fits, so
+// nothing is left over except when the pass budget runs out.
+static Task *ready[MAX_TASKS];
+static uint ready_next = 0;
+static uint ready_count = 0;
+
+static inline bool task_ranks_before(const Task *a, const Task *b)
+{
+#if ASYNC_TASK_ORDER == TASK_ORDER_PRIORITY
+    if (a->priority != b->priority)
+        return a->priority < b->priority;
+#endif
+    return async_time_before(task_abs_deadline(a), task_abs_deadline(b));
+}
+
+static void ready_insert(Task *pt)
+{
+    uint n = ready_count++;
+    while (n > 0 && task_ranks_before(pt, ready[n-1]))
+    {
+        ready[n] = ready[n-1];
+        n--;
+    }
+    ready[n] = pt;
+}
+
+// A task deleted while it waits in the ready array must not run
+static void ready_forget(Task *pt)
+{
+    for (uint i=ready_next; i<ready_count; i++)
+    {
+        if (ready[i] == pt)
+            ready[i] = NULL;
+    }
+}
+
+// End the pass early once it has used its time budget
+static inline bool pass_budget_spent(async_time_t pass_start)
+{
+#if ASYNC_TASK_PASS_BUDGET_US
+    return async_time_reached(async_time_now(), pass_start + ASYNC_TASK_PASS_BUDGET_US);
+#else
+    (void)pass_start;
+    return false;
+#endif
+}
+#endif
+
+// Free slots: one bit per task (set = free) plus a summary bit per word, so
+// allocation is two count-trailing-zeros and freeing is two ORs. Up to 1024
+// tasks the summary is a single word; larger pools (host simulations) scan
+// the summary words.
+#if MAX_TASKS > (1u << 24)
+#error "MAX_TASKS is limited to 2^24 (task handle index bits)"
+#endif
+#define POOL_WORDS ((MAX_TASKS + 31) / 32)
+#define SUMMARY_WORDS ((POOL_WORDS + 31) / 32)
+static uint32_t free_map[POOL_WORDS];
+static uint32_t free_words[SUMMARY_WORDS]; // bit w set: free_map[w] has a free slot
+static bool pool_ready = false;
+
+// Handle layout: slot index in the low bits, generation in the rest
+#if MAX_TASKS <= 0x10000
+#define HANDLE_INDEX_BITS (16)
+#else
+#define HANDLE_INDEX_BITS (24)
+#endif
+#define HANDLE_GEN_MASK ((1u << (32 - HANDLE_INDEX_BITS)) - 1)
+
+static void pool_init(void)
+{
+    for (uint i=0; i<MAX_TASKS; i++)
+    {
+        free_map[i / 32] |= 1u << (i % 32);
+        all_tasks[i].generation = 1;
+    }
+    for (uint w=0; w<POOL_WORDS; w++)
+        free_words[w / 32] |= 1u << (w % 32);
+#if ASYNC_TASK_USE_WHEEL
+    wheel_init(async_time_now());
+#endif
+    pool_ready = true;
+}
+
+static Task *pool_alloc(void)
+{
+    uint s = 0;
+    while (!free_words[s])
+    {
+        if (++s == SUMMARY_WORDS)
+            return NULL;
+    }
+    uint w = s * 32 + __builtin_ctz(free_words[s]);
+    uint bit = __builtin_ctz(free_map[w]);
+    free_map[w] &= ~(1u << bit);
+    if (!free_map[w])
+        free_words[s] &= ~(1u << (w % 32));
+    return &all_tasks[w * 32 + bit];
+}
+
+static void pool_free(Task *pt)
+{
+    uint i = pt - all_tasks;
+    free_map[i / 32] |= 1u << (i % 32);
+    free_words[i / 1024] |= 1u << ((i / 32) % 32);
+    // Invalidate outstanding handles; generation 0 is never handed out
+    pt->generation = (pt->generation + 1) & HANDLE_GEN_MASK;
+    if (pt->generation == 0)
+        pt->generation = 1;
+}
+
+#if ASYNC_TASK_USE_SOA && !ASYNC_TASK_USE_WHEEL
+
+// Hot deadline table: low 32 bits of each slot's next_run_at, compared with the
+// signed difference like async_time_before(). A deadline further out than the
+// horizon is stored at the horizon; the pass then finds the slot early, sees on
+// next_run_at that it is not due yet and stores it again. Padded to whole
+// bitmap words so the compare loop needs no tail handling.
+#define DUE_HORIZON ((async_time_t)1 << 30)
+#define TAIL_MASK (MAX_TASKS % 32 ? (1u << (MAX_TASKS % 32)) - 1 : ~0u)
+static uint32_t due_lo[POOL_WORDS * 32] __attribute__((aligned(16)));
+
+static inline void due_store(const Task *pt, async_time_t tm)
+{
+    async_time_t at = pt->next_run_at;
+    if (async_time_before(tm + DUE_HORIZON, at))
+        at = tm + DUE_HORIZON;
+    due_lo[pt - all_tasks] = (uint32_t)at;
+}
+
+// Taken slots of bitmap word w
+static inline uint32_t slots_taken(uint w)
+{
+    return ~free_map[w] & (w == POOL_WORDS - 1 ? TAIL_MASK : ~0u);
+}
+
+// Bit b set: due_lo[w * 32 + b] has been reached at now32. The sign bit of
+// now32 - due is set exactly for the slots that are not due yet.
+static inline uint32_t due_compare(uint w, uint32_t now32)
+{
+    const uint32_t *due = &due_lo[w * 32];
+    uint32_t not_due = 0;
+#if defined(__SSE2__)
+    __m128i now = _mm_set1_epi32((int)now32);
+    for (uint b=0; b<32; b+=4)
+    {
+        __m128i diff = _mm_sub_epi32(now, _mm_load_si128((const __m128i *)(due + b)));
+        not_due |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(diff)) << b;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    static const uint32_t lane_bit[4] = {1, 2, 4, 8};
+    uint32x4_t now = vdupq_n_u32(now32);
+    uint32x4_t weight = vld1q_u32(lane_bit);
+    for (uint b=0; b<32; b+=4)
+    {
+        uint32x4_t sign = vshrq_n_u32(vsubq_u32(now, vld1q_u32(due + b)), 31);
+        not_due |= vaddvq_u32(vmulq_u32(sign, weight)) << b;
+    }
+#else
+    for (uint b=0; b<32; b++)
+        not_due |= ((now32 - due[b]) >> 31) << b;
+#endif
+    return ~not_due;
+}
+
+// Slots of word w that are due at tm. The hot table only narrows the search:
+// each candidate is confirmed on its Task, and one that was stored at the
+// horizon is stored again.
+static uint32_t due_word(uint w, async_time_t tm)
+{
+    uint32_t candidates = due_compare(w, (uint32_t)tm) & slots_taken(w);
+    uint32_t due = 0;
+    while (candidates)
+    {
+        uint b = __builtin_ctz(candidates);
+        candidates &= candidates - 1;
+        Task *pt = &all_tasks[w * 32 + b];
+        if (!pt->callback)
+            continue;
+        if (async_time_reached(tm, pt->next_run_at))
+            due |= 1u << b;
+        else
+            due_store(pt, tm);
+    }
+    return due;
+}
+#define DUE_STORE(pt, tm) due_store((pt), (tm))
+#else
+#define DUE_STORE(pt, tm) ((void)0)
+#endif
+
+// Pending task_signal() calls, one bit per slot: set from anywhere, taken by the scheduler
+static _Atomic uint32_t signal_map[POOL_WORDS];
+static atomic_bool signals_pending;     // set after a bit, so a pass without signals skips the map
+
+static inline void signal_clear(const Task *pt)
+{
+    uint i = pt - all_tasks;
+    atomic_fetch_and_explicit(&signal_map[i / 32], ~(1u << (i % 32)), memory_order_relaxed);
+}
+
+void task_signal(Task *task)
+{
+    if (task < all_tasks || task >= all_tasks + MAX_TASKS)
+        return;
+    uint i = task - all_tasks;
+    atomic_fetch_or_explicit(&signal_map[i / 32], 1u << (i % 32), memory_order_release);
+    atomic_store_explicit(&signals_pending, true, memory_order_release);
+#ifndef ASYNC_TIME_HOST
+    __sev(); // end a tickless sleep early
+#endif
+}
+
+void task_wait_signal(Task *task)
+{
+    task->on_signal = true;
+#if ASYNC_TASK_USE_WHEEL
+    wheel_remove(task);
+#endif
+    async_time_t tm = async_time_now();
+    task->next_run_at = tm + TASK_PARKED;
+    DUE_STORE(task, tm);
+}
+
+void task_wait_timer(Task *task)
+{
+    task->on_signal = false;
+    signal_clear(task);
+    async_time_t tm = async_time_now();
+#if ASYNC_TASK_USE_WHEEL
+    wheel_remove(task);
+    task->next_run_at = tm + task->interval;
+    wheel_insert(task);
+#else
+    task->next_run_at = tm + task->interval;
+    DUE_STORE(task, tm);
+#endif
+}
+
+// Make every signaled task due at tm; called at the start of a pass
+static void signals_take(async_time_t tm)
+{
+    if (!atomic_exchange_explicit(&signals_pending, false, memory_order_acquire))
+        return;
+    for (uint w=0; w<POOL_WORDS; w++)
+    {
+        if (!atomic_load_explicit(&signal_map[w], memory_order_relaxed))
+            continue;
+        uint32_t bits = atomic_exchange_explicit(&signal_map[w], 0, memory_order_acquire);
+        while (bits)
+        {
+            Task *pt = &all_tasks[w * 32 + __builtin_ctz(bits)];
+            bits &= bits - 1;
+            if (!pt->is_taken)
+                continue;
+#if ASYNC_TASK_USE_WHEEL
+            // Start of the current tick, so this pass releases it
+            wheel_remove(pt);
+            pt->next_run_at = tm & ~(async_time_t)((1u << WHEEL_TICK_SHIFT) - 1);
+            wheel_insert(pt);
+#else
+            pt->next_run_at = tm;
+            DUE_STORE(pt, tm);
+#endif
+        }
+    }
+}
+
+Task *task_add(void)
+{
+    if (!pool_ready)
+        pool_init();
+    Task *pt = pool_alloc();
+    if (!pt)
+        return NULL;
+    pt->interval = 0;
+    pt->next_run_at = async_time_now();
+    DUE_STORE(pt, pt->next_run_at);
+    pt->missed = 0;
+    pt->catch_up = CATCH_UP_SKIP;
+    pt->rel_deadline = 0;
+    pt->priority = 0;
+    pt->coro_line = 0;
+    pt->on_signal = false;
+    signal_clear(pt);
+    PROFILE_CLEAR(pt);
+    pt->callback = NULL;
+    pt->is_taken = true;
+#if ASYNC_TASK_USE_WHEEL
+    wheel_insert(pt);
+#endif
+    return pt;
+}
+
+void task_delete(Task* task) {
+    // Pointer range check instead of a pool scan
+    if (task < all_tasks || task >= all_tasks + MAX_TASKS || !task->is_taken)
+        return;
+#if ASYNC_TASK_USE_WHEEL
+    wheel_remove(task);
+#endif
+#if ASYNC_TASK_ORDER != TASK_ORDER_FIFO
+    ready_forget(task);
+#endif
+    task->callback = NULL;
+    task->is_taken = false;
+    signal_clear(task);
+    pool_free(task);
+}
+
+task_handle_t task_handle(const Task *task)
+{
+    if (task < all_tasks || task >= all_tasks + MAX_TASKS || !task->is_taken)
+        return TASK_HANDLE_NONE;
+    return ((uint32_t)task->generation << HANDLE_INDEX_BITS) | (uint32_t)(task - all_tasks);
+}
+
+Task *task_from_handle(task_handle_t handle)
+{
+    uint32_t i = handle & ((1u << HANDLE_INDEX_BITS) - 1);
+    if (i >= MAX_TASKS)
+        return NULL;
+    Task *pt = &all_tasks[i];
+    // A deleted or reused slot has moved on to a newer generation
+    if (!pt->is_taken || pt->generation != (handle >> HANDLE_INDEX_BITS))
+        return NULL;
+    return pt;
+}
+
+bool task_delete_handle(task_handle_t handle)
+{
+    Task *pt = task_from_handle(handle);
+    if (!pt)
+        return false;
+    task_delete(pt);
+    return true;
+}
+
+#if ASYNC_TASK_USE_WHEEL
+
+// Re-arm a task that is about to run; a signal-driven task stays out of the
+// wheel until it is signaled (or task_sleep_until() gives it a timeout)
+static inline void task_rearm(Task *pt, async_time_t tm)
+{
+    task_reschedule(pt, tm);
+    if (!pt->on_signal)
+        wheel_insert(pt);
+}
+
+// Override the next run time from inside the callback (the task is already re-armed)
+void task_sleep_until(Task *task, async_time_t wake_at)
+{
+    wheel_remove(task);
+    task->next_run_at = wake_at;
+    wheel_insert(task);
+}
+
+#if ASYNC_TASK_ORDER == TASK_ORDER_FIFO
+
+// Dispatch expired timers - call this every 1ms (or as fast as possible from loop)
+void async_tasks_update()
+{
+    if (!pool_ready)
+        return;
+    async_time_t tm = async_time_now();
+    PROFILE_PASS();
+    signals_take(tm);
+    wheel_advance(tm);
+    Task *pt;
+    while ((pt = wheel_pop_expired()) != NULL)
+    {
+        // Re-arm before the callback so it can delete itself; a task without
+        // a callback is parked off the wheel until it is given one
+        if (pt->callback)
+        {
+            PROFILE_BEGIN(pt);
+            PRIO_STATS_RECORD(pt);
+            task_rearm(pt, tm);
+            pt->callback(pt);
+            PROFILE_END(pt);
+        }
+        else
+        {
+            pt->next_run_at = tm;
+            wheel_insert(pt);
+        }
+    }
+}
+
+#else
+
+// Rank the expired timers, then dispatch them in priority/deadline order
+void async_tasks_update()
+{
+    if (!pool_ready)
+        return;
+    async_time_t tm = async_time_now();
+    PROFILE_PASS();
+    signals_take(tm);
+    wheel_advance(tm);
+    Task *pt;
+    while ((pt = wheel_pop_expired()) != NULL)
+    {
+        if (pt->callback)
+            ready_insert(pt);
+        else
+        {
+            pt->next_run_at = tm;   // parked, as in the FIFO order
+            wheel_insert(pt);
+        }
+    }
+    while (ready_next < ready_count)
+    {
+        pt = ready[ready_next++];
+        if (!pt)
+            continue;               // deleted by an earlier callback
+        if (pt->callback)
+        {
+            PROFILE_BEGIN(pt);
+            PRIO_STATS_RECORD(pt);
+            task_rearm(pt, tm);
+            pt->callback(pt);
+            PROFILE_END(pt);
+        }
+        else
+        {
+            pt->next_run_at = tm;
+            wheel_insert(pt);
+        }
+        if (pass_budget_spent(tm))
+            break;
+    }
+    // Pass ended early: the rest are still due and are ranked again next pass
+    while (ready_next < ready_count)
+    {
+        pt = ready[ready_next++];
+        if (pt)
+            wheel_insert(pt);
+    }
+    ready_next = 0;
+    ready_count = 0;
+}
+
+#endif
+
+bool scheduler_next_deadline(async_time_t *deadline)
+{
+    return pool_ready && wheel_next_expiry(deadline);
+}
+
+#else
+
+// Override the next run time from inside the callback (the task is already re-armed)
+void task_sleep_until(Task *task, async_time_t wake_at)
+{
+    task->next_run_at = wake_at;
+    DUE_STORE(task, async_time_now());
+}
+
+#if ASYNC_TASK_ORDER == TASK_ORDER_FIFO
+
+// Update all active tasks - call this every 1ms (or as fast as possible from loop)
+void async_tasks_update()
+{
+    // One time snapshot per pass
+    async_time_t tm = async_time_now();
+    PROFILE_PASS();
+    signals_take(tm);
+#if ASYNC_TASK_USE_SOA
+    if (!pool_ready)
+        return;
+    for (uint w=0; w<POOL_WORDS; w++)
+    {
+        for (uint32_t due = due_word(w, tm); due; due &= due - 1)
+        {
+            Task *pt = &all_tasks[w * 32 + __builtin_ctz(due)];
+            if (!pt->callback)
+                continue;           // deleted or stopped by an earlier callback
+            PROFILE_BEGIN(pt);
+            PRIO_STATS_RECORD(pt);
+            task_reschedule(pt, tm);
+            due_store(pt, tm);
+            pt->callback(pt);
+            PROFILE_END(pt);
+        }
+    }
+#else
+    for (uint i=0; i<MAX_TASKS; i++) {
+        Task *pt = &all_tasks[i];
+        if (pt->is_taken && pt->callback)
+        {
+            if (async_time_reached(tm, pt->next_run_at))
+            {
+                PROFILE_BEGIN(pt);
+                PRIO_STATS_RECORD(pt);
+                task_reschedule(pt, tm);
+                pt->callback(pt);
+                PROFILE_END(pt);
+            }
+        }
+    }
+#endif
+}
+
+#else
+
+// Rank the due tasks, then run them in priority/deadline order
+void async_tasks_update()
+{
+    // One time snapshot per pass
+    async_time_t tm = async_time_now();
+    PROFILE_PASS();
+    signals_take(tm);
+#if ASYNC_TASK_USE_SOA
+    if (!pool_ready)
+        return;
+    for (uint w=0; w<POOL_WORDS; w++)
+    {
+        for (uint32_t due = due_word(w, tm); due; due &= due - 1)
+            ready_insert(&all_tasks[w * 32 + __builtin_ctz(due)]);
+    }
+#else
+    for (uint i=0; i<MAX_TASKS; i++) {
+        Task *pt = &all_tasks[i];
+        if (pt->is_taken && pt->callback && async_time_reached(tm, pt->next_run_at))
+            ready_insert(pt);
+    }
+#endif
+    while (ready_next < ready_count)
+    {
+        Task *pt = ready[ready_next++];
+        if (!pt || !pt->callback)
+            continue;               // deleted or stopped by an earlier callback
+        PROFILE_BEGIN(pt);
+        PRIO_STATS_RECORD(pt);
+        task_reschedule(pt, tm);
+        DUE_STORE(pt, tm);
+        pt->callback(pt);
+        PROFILE_END(pt);
+        if (pass_budget_spent(tm))
+            break;                  // the rest are still due and are ranked again next pass
+    }
+    ready_next = 0;
+    ready_count = 0;
+}
+
+#endif
+
+#if ASYNC_TASK_USE_SOA
+
+// Earliest deadline: a branchless minimum over the hot table, then, only if
+// something is already due, an exact scan that skips stopped tasks (no callback)
+bool scheduler_next_deadline(async_time_t *deadline)
+{
+    if (!pool_ready)
+        return false;
+    async_time_t tm = async_time_now();
+    uint32_t now32 = (uint32_t)tm;
+    bool found = false;
+    int32_t best = INT32_MAX;
+    for (uint w=0; w<POOL_WORDS; w++)
+    {
+        uint32_t taken = slots_taken(w);
+        if (!taken)
+            continue;
+        found = true;
+        const uint32_t *due = &due_lo[w * 32];
+        if (taken == ~0u)
+        {
+            for (uint b=0; b<32; b++)   // full word: a plain minimum, which vectorizes
+            {
+                int32_t diff = (int32_t)(due[b] - now32);
+                best = diff < best ? diff : best;
+            }
+            continue;
+        }
+        for (; taken; taken &= taken - 1)
+        {
+            int32_t diff = (int32_t)(due[__builtin_ctz(taken)] - now32);
+            best = diff < best ? diff : best;
+        }
+    }
+    if (found && best <= 0)
+    {
+        found = false;
+        for (uint w=0; w<POOL_WORDS; w++)
+        {
+            for (uint32_t taken = slots_taken(w); taken; taken &= taken - 1)
+            {
+                uint i = w * 32 + __builtin_ctz(taken);
+                int32_t diff = (int32_t)(due_lo[i] - now32);
+                if (diff <= 0 && !all_tasks[i].callback)
+                    continue;       // stopped: due in the table, but never runs
+                if (!found || diff < best)
+                {
+                    best = diff;
+                    found = true;
+                }
+            }
+        }
+    }
+    if (found)
+        *deadline = tm + (async_time_t)(int64_t)best;
+    return found;
+}
+
+#else
+
+bool scheduler_next_deadline(async_time_t *deadline)
+{
+    bool found = false;
+    for (uint i=0; i<MAX_TASKS; i++) {
+        Task *pt = &all_tasks[i];
+        if (pt->is_taken && pt->callback)
+        {
+            if (!found || async_time_before(pt->next_run_at, *deadline))
+            {
+                *deadline = pt->next_run_at;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+#endif
+
+#endif
+
+#if ASYNC_ALARM
+// Arm the alarm for the deadline and wait for it, or for any other event. The
+// alarm ISR only wakes the core; the due tasks run in the next async_tasks_update().
+void scheduler_sleep_until(async_time_t deadline)
+{
+    if (deadline == SCHEDULER_NO_DEADLINE)
+        async_alarm_cancel();
+    else
+        async_alarm_arm(deadline);
+    async_alarm_wait();
+}
+// Host builds (see ../host) provide their own scheduler_sleep_until()
+#elif !defined(ASYNC_TASK_HOST)
+// Wait for the deadline or any event (interrupt, __sev() from an ISR or the other core)
+void scheduler_sleep_until(async_time_t deadline)
+{
+    if (deadline == SCHEDULER_NO_DEADLINE)
+    {
+        __wfe();
+        return;
+    }
+    best_effort_wfe_or_timeout(from_us_since_boot(deadline));
+}
+#endif
+
+// Sleep until the next deadline, or until an interrupt/event wakes the core
+void scheduler_idle()
+{
+    async_time_t deadline = 0;
+    if (!scheduler_next_deadline(&deadline))
+    {
+        scheduler_sleep_until(SCHEDULER_NO_DEADLINE);
+        return;
+    }
+    if (async_time_before(async_time_now(), deadline))
+        scheduler_sleep_until(deadline);
+}
+
+// Main loop replacement: run due tasks, then idle until the next one
+void scheduler_run()
+{
+    while (true)
+    {
+        async_tasks_update();
+        scheduler_idle();
+    }
+}
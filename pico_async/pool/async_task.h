@@ -0,0 +1,152 @@
+#ifndef ASYNC_TASK_H
+#define ASYNC_TASK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "async_time.h"
+#include "async_profile.h"
+#ifdef ASYNC_TASK_HOST
+#include <sys/types.h>  // uint, which pico/types.h provides on the device
+#endif
+
+// Task pool capacity (override from CMake, e.g. MAX_TASKS=256; host simulations go up to 2^24)
+#ifndef MAX_TASKS
+#define MAX_TASKS (16)
+#endif
+
+// Scheduler backend:
+//  0 - slot array, async_tasks_update() polls every slot (default)
+//  1 - hierarchical timing wheel (timer_wheel.c), O(1) add/delete and
+//      async_tasks_update() only touches tasks that are due
+#ifndef ASYNC_TASK_USE_WHEEL
+#define ASYNC_TASK_USE_WHEEL 0
+#endif
+
+// Slot array layout (ASYNC_TASK_USE_WHEEL=0):
+//  0 - the pass reads next_run_at, is_taken and callback from every Task (default)
+//  1 - structure of arrays: the pass reads a packed table of 32-bit deadlines,
+//      32 slots per step (SSE2/NEON on the host, branchless on the M33), masked
+//      by the free-slot bitmap, and only touches the Task structs of due slots.
+//      next_run_at must then only be changed through the task_* functions.
+#ifndef ASYNC_TASK_USE_SOA
+#define ASYNC_TASK_USE_SOA 0
+#endif
+
+// Order in which tasks that are due in the same pass are dispatched
+#define TASK_ORDER_FIFO     (0)     // pool order (default)
+#define TASK_ORDER_PRIORITY (1)     // Task.priority (0 = most urgent), then earliest deadline
+#define TASK_ORDER_EDF      (2)     // earliest deadline first (see Task.rel_deadline)
+#ifndef ASYNC_TASK_ORDER
+#define ASYNC_TASK_ORDER TASK_ORDER_FIFO
+#endif
+
+// With an ordered dispatch, end a pass once it has run this long (0 = never) so an
+// urgent task that became due meanwhile is dispatched before the rest of the pass
+#ifndef ASYNC_TASK_PASS_BUDGET_US
+#define ASYNC_TASK_PASS_BUDGET_US (0)
+#endif
+
+// Priority classes and per-class dispatch latency statistics (task_prio_stats())
+#ifndef ASYNC_TASK_PRIORITIES
+#define ASYNC_TASK_PRIORITIES (4)
+#endif
+#ifndef ASYNC_TASK_PRIO_STATS
+#define ASYNC_TASK_PRIO_STATS 0
+#endif
+
+// Millisecond timestamp for application code; the scheduler itself runs on async_time_t
+static inline uint32_t millis()
+{
+    return (uint32_t)(async_time_now() / 1000u);
+}
+
+typedef struct Task Task; // Forward declararion so typedefs can use it
+
+typedef void (*TaskCallback)(Task *task);
+
+// What a periodic task does when it runs a whole interval (or more) late.
+// On-time runs are always anchored to the original phase (next += interval).
+typedef enum {
+    CATCH_UP_SKIP = 0,      // Run once, drop the missed periods, keep the phase (default)
+    CATCH_UP_ONCE,          // Run once and restart the period from now
+    CATCH_UP_BURST,         // Run once per missed period, one run per update, until caught up
+} TaskCatchUp;
+
+// Task structure with linked list pointer
+typedef struct Task {
+    async_time_t next_run_at; // Next execution time in microseconds
+    async_time_t interval;  // Interval between executions in microseconds (use ASYNC_MS())
+    uint32_t missed;        // Deadlines missed by a whole interval or more
+    union {
+        void *ptr;
+        uint data[4];
+        uint value;
+        uint status;
+    } user;
+    TaskCallback callback;  // Function to call (NULL = not active)
+#if ASYNC_TASK_USE_WHEEL
+    struct Task *next;      // Next task in the same wheel slot (or free list)
+    struct Task **pprev;    // Link pointing at this task, NULL if not scheduled
+#endif
+    async_time_t rel_deadline; // Deadline after next_run_at for EDF/lateness (0 = interval)
+    uint8_t catch_up;       // TaskCatchUp policy
+    uint8_t priority;       // 0 = most urgent, up to ASYNC_TASK_PRIORITIES - 1
+    bool is_taken;
+    uint16_t coro_line;     // Resume point of a coroutine task (async_coro.h)
+    uint16_t generation;    // Bumped on delete so old handles stop matching
+    bool on_signal;         // Runs only after task_signal() (set by task_wait_signal())
+} Task;
+
+// Dispatch latency of one priority class: time from next_run_at to the callback
+typedef struct {
+    uint32_t runs;
+    uint32_t late;          // runs that started after the task's deadline
+    async_time_t total_latency;
+    async_time_t max_latency;
+} task_prio_stats_t;
+
+// Opaque task reference: slot index plus the slot's generation at the time the
+// handle was taken. Once the task is deleted the handle no longer resolves,
+// even if the slot has been reused. 0 is never a valid handle.
+typedef uint32_t task_handle_t;
+#define TASK_HANDLE_NONE (0u)
+
+// A new task has no callback and does not run until the caller sets one
+// (with interval and the other fields) after task_add(); NULL if the pool is full
+Task *task_add(void);
+void task_delete(Task* task);
+task_handle_t task_handle(const Task *task);
+Task *task_from_handle(task_handle_t handle);   // NULL if the task was deleted
+bool task_delete_handle(task_handle_t handle);  // false for a stale handle
+void task_sleep_until(Task *task, async_time_t wake_at); // from the task's own callback
+// Event-triggered tasks. After task_wait_signal() the task no longer runs on its
+// timer, only on the pass after a task_signal(); signals raised before it gets
+// to run are merged into one run. task_signal() on a timed task makes it due
+// now. task_signal() is safe from an ISR or the other core. task_wait_timer()
+// puts the task back on its timer, next run one interval from now, and drops
+// a signal that has not been taken yet.
+void task_signal(Task *task);
+void task_wait_signal(Task *task);
+void task_wait_timer(Task *task);
+void async_tasks_update();
+#if ASYNC_TASK_PRIO_STATS
+const task_prio_stats_t *task_prio_stats(uint8_t priority);
+#endif
+#if ASYNC_PROFILE
+// Profiler (async_profile.h): one entry per pool slot, printed with task_profile_dump()
+void task_profile_reset();
+void task_profile_dump();
+const async_task_profile_t *task_profile(const Task *task);
+#endif
+
+// Tickless idle: sleep until the earliest task deadline instead of polling.
+// An interrupt (or __sev() from an ISR or the other core) ends the sleep early.
+// Deadline for scheduler_sleep_until(): no task is pending, wait for an interrupt or __sev()
+#define SCHEDULER_NO_DEADLINE (UINT64_MAX)
+
+bool scheduler_next_deadline(async_time_t *deadline);
+void scheduler_sleep_until(async_time_t deadline);
+void scheduler_idle();
+void scheduler_run();
+
+#endif
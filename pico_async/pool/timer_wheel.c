@@ -0,0 +1,237 @@
+#include <stddef.h>
+#include "timer_wheel.h"
+
+// Only built into the scheduler when ASYNC_TASK_USE_WHEEL is set
+#if ASYNC_TASK_USE_WHEEL
+
+static Task *slots[WHEEL_LEVELS][WHEEL_SLOTS];
+static Task *overflow;  // deadlines past the last level
+static Task *pending;   // due at or before the current tick, picked up by the next advance
+static Task *parked;    // no callback: off the wheel until one is set
+static Task *expired;   // due, waiting to be dispatched
+static uint64_t wheel_tick; // last processed tick
+
+static void list_push(Task **head, Task *task)
+{
+    task->next = *head;
+    if (*head)
+        (*head)->pprev = &task->next;
+    *head = task;
+    task->pprev = head;
+}
+
+static void list_unlink(Task *task)
+{
+    *task->pprev = task->next;
+    if (task->next)
+        task->next->pprev = task->pprev;
+    task->next = NULL;
+    task->pprev = NULL;
+}
+
+// First tick at or after the deadline, so a timer never fires early
+static inline uint64_t expiry_tick(const Task *task)
+{
+    return (task->next_run_at + (1u << WHEEL_TICK_SHIFT) - 1) >> WHEEL_TICK_SHIFT;
+}
+
+static Task **slot_for(uint64_t expires)
+{
+    if (expires <= wheel_tick)
+        return &pending;
+    uint64_t delta = expires - wheel_tick;
+    for (uint32_t level = 0; level < WHEEL_LEVELS; level++)
+    {
+        if (delta < (1u << (WHEEL_BITS * (level + 1))))
+            return &slots[level][(expires >> (WHEEL_BITS * level)) & WHEEL_MASK];
+    }
+    return &overflow;
+}
+
+// Move every task in a list to the expired list, or to a lower level
+static void cascade(Task **head)
+{
+    Task *pt = *head;
+    *head = NULL;
+    while (pt)
+    {
+        Task *next = pt->next;
+        uint64_t expires = expiry_tick(pt);
+        if (expires <= wheel_tick)
+            list_push(&expired, pt);
+        else
+            list_push(slot_for(expires), pt);
+        pt = next;
+    }
+}
+
+void wheel_init(async_time_t now)
+{
+    wheel_tick = now >> WHEEL_TICK_SHIFT;
+}
+
+// A task without a callback would only expire and be parked again on every
+// tick, keeping a tickless core awake, so it waits on the parked list
+void wheel_insert(Task *task)
+{
+    list_push(task->callback ? slot_for(expiry_tick(task)) : &parked, task);
+}
+
+void wheel_remove(Task *task)
+{
+    if (task->pprev)
+        list_unlink(task);
+}
+
+// First tick after the current one at which wheel_advance() has work: the
+// next occupied slot of level 0, or the tick at which the next occupied slot
+// of a higher level (or the overflow list) is cascaded. UINT64_MAX if none.
+static uint64_t next_busy_tick(void)
+{
+    uint64_t next = UINT64_MAX;
+    for (uint32_t level = 0; level < WHEEL_LEVELS; level++)
+    {
+        uint32_t shift = WHEEL_BITS * level;
+        if (next <= (((wheel_tick >> shift) + 1) << shift))
+            return next;    // this level and the ones above start later
+        uint32_t cur = (wheel_tick >> shift) & WHEEL_MASK;
+        for (uint32_t i = 1; i <= WHEEL_SLOTS; i++)
+        {
+            if (slots[level][(cur + i) & WHEEL_MASK])
+            {
+                uint64_t start = ((wheel_tick >> shift) + i) << shift;
+                if (start < next)
+                    next = start;
+                break;
+            }
+        }
+    }
+    if (overflow)
+    {
+        uint64_t start = ((wheel_tick >> (WHEEL_BITS * WHEEL_LEVELS)) + 1) << (WHEEL_BITS * WHEEL_LEVELS);
+        if (start < next)
+            next = start;
+    }
+    return next;
+}
+
+// Move parked tasks that have been given a callback back onto the wheel
+static void unpark(void)
+{
+    Task *pt = parked;
+    while (pt)
+    {
+        Task *next = pt->next;
+        if (pt->callback)
+        {
+            list_unlink(pt);
+            wheel_insert(pt);
+        }
+        pt = next;
+    }
+}
+
+void wheel_advance(async_time_t now)
+{
+    uint64_t now_tick = now >> WHEEL_TICK_SHIFT;
+    unpark();
+    cascade(&pending);
+    // Jump straight to the ticks that have work, so a long sleep costs one
+    // step per occupied slot rather than one per elapsed tick
+    while (wheel_tick < now_tick)
+    {
+        uint64_t next = next_busy_tick();
+        if (next > now_tick)
+        {
+            wheel_tick = now_tick;
+            break;
+        }
+        wheel_tick = next;
+        // Refill lower levels when the level below wraps around
+        uint32_t level = 1;
+        while (level <= WHEEL_LEVELS && (wheel_tick & ((1u << (WHEEL_BITS * level)) - 1)) == 0)
+        {
+            if (level == WHEEL_LEVELS)
+                cascade(&overflow);
+            else
+                cascade(&slots[level][(wheel_tick >> (WHEEL_BITS * level)) & WHEEL_MASK]);
+            level++;
+        }
+        cascade(&slots[0][wheel_tick & WHEEL_MASK]);
+    }
+}
+
+// Returns whether the list holds a task that will fire
+static bool list_min_expiry(Task *pt, bool *found, uint64_t *expires)
+{
+    bool any = false;
+    for (; pt; pt = pt->next)
+    {
+        if (!pt->callback)
+            continue;   // stopped since it was inserted, never fires
+        uint64_t tick = expiry_tick(pt);
+        any = true;
+        if (!*found || tick < *expires)
+        {
+            *expires = tick;
+            *found = true;
+        }
+    }
+    return any;
+}
+
+bool wheel_next_expiry(async_time_t *expiry)
+{
+    // Tasks stopped after they were inserted (no callback) do not count; a
+    // parked task that has been given a callback goes back on the next advance
+    bool due = (expired != NULL);
+    for (Task *pt = pending; pt && !due; pt = pt->next)
+        due = (pt->callback != NULL);
+    for (Task *pt = parked; pt && !due; pt = pt->next)
+        due = (pt->callback != NULL);
+    if (due)
+    {
+        *expiry = (async_time_t)wheel_tick << WHEEL_TICK_SHIFT;
+        return true;
+    }
+
+    // Slots of one level cover consecutive ranges, so the first occupied slot
+    // after the current one holds that level's earliest deadlines. Nothing in
+    // a slot expires before the slot's range starts, so a slot (or the
+    // overflow list) that starts after the best deadline so far is not scanned.
+    bool found = false;
+    uint64_t expires = 0;
+    for (uint32_t level = 0; level < WHEEL_LEVELS; level++)
+    {
+        uint32_t shift = WHEEL_BITS * level;
+        uint32_t cur = (wheel_tick >> shift) & WHEEL_MASK;
+        for (uint32_t i = 1; i <= WHEEL_SLOTS; i++)
+        {
+            Task *head = slots[level][(cur + i) & WHEEL_MASK];
+            if (!head)
+                continue;
+            uint64_t start = ((wheel_tick >> shift) + i) << shift;
+            if (found && start >= expires)
+                break;
+            // A slot holding only stopped tasks does not end the search
+            if (list_min_expiry(head, &found, &expires))
+                break;
+        }
+    }
+    uint64_t overflow_start = ((wheel_tick >> (WHEEL_BITS * WHEEL_LEVELS)) + 1) << (WHEEL_BITS * WHEEL_LEVELS);
+    if (!found || overflow_start < expires)
+        list_min_expiry(overflow, &found, &expires);
+    // Report the tick start: that is when wheel_advance() will release the task
+    *expiry = (async_time_t)expires << WHEEL_TICK_SHIFT;
+    return found;
+}
+
+Task *wheel_pop_expired(void)
+{
+    Task *pt = expired;
+    if (pt)
+        list_unlink(pt);
+    return pt;
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+#include "async_task.h"
+
+// Hierarchical timing wheel for Task timers.
+// WHEEL_LEVELS levels of WHEEL_SLOTS slots each; level N slot covers
+// WHEEL_SLOTS^N ticks. Deadlines beyond the last level wait on an overflow
+// list. Insert and remove are O(1), expiry is amortized O(1) per task.
+#define WHEEL_BITS   (6)
+#define WHEEL_SLOTS  (1u << WHEEL_BITS)
+#define WHEEL_MASK   (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS (4)
+
+// Tick length is 2^WHEEL_TICK_SHIFT microseconds (default 1024 us).
+// Timers never fire early; they fire up to one tick late.
+#ifndef WHEEL_TICK_SHIFT
+#define WHEEL_TICK_SHIFT (10)
+#endif
+
+void wheel_init(async_time_t now);
+void wheel_insert(Task *task);      // schedules task at task->next_run_at, parked while it has no callback
+void wheel_remove(Task *task);      // no-op if the task is not scheduled
+void wheel_advance(async_time_t now); // moves every task due at 'now' onto the expired list
+Task *wheel_pop_expired(void);      // NULL when nothing is left to dispatch
+bool wheel_next_expiry(async_time_t *expiry); // when the earliest active task will fire
+
+#endif
@@ -0,0 +1,226 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// Lock-free single-producer/single-consumer ring of fixed-size records.
+//
+// One producer (a task, an ISR, or the other core) and one consumer (a task or
+// the other core). Each side only writes its own index, so neither side needs
+// to disable interrupts or take a spinlock. Producer and consumer may not share
+// a ring end: two ISRs pushing into the same ring need two rings.
+//
+//   static sample_t samples_buf[16];
+//   static spsc_ring_t samples;
+//   spsc_ring_init(&samples, samples_buf, sizeof(sample_t), 16);
+//
+//   ISR:   spsc_ring_push(&samples, &s);
+//   task:  while (spsc_ring_pop(&samples, &s)) { ... }
+
+// Producer and consumer fields live on separate lines so the two sides do not
+// keep invalidating each other's cache (hosts; RP2350 SRAM is uncached, where
+// this only costs a few bytes)
+#ifndef SPSC_CACHE_LINE
+#ifdef ASYNC_TIME_HOST
+#define SPSC_CACHE_LINE (64)
+#else
+#define SPSC_CACHE_LINE (32)
+#endif
+#endif
+
+// Called after records are published: wakes a consumer sleeping in WFE on the
+// other core (scheduler_idle()). An ISR producer wakes its own core anyway.
+#ifndef SPSC_RING_NOTIFY
+#ifdef ASYNC_TIME_HOST
+#define SPSC_RING_NOTIFY() ((void)0)
+#else
+#include "hardware/sync.h"
+#define SPSC_RING_NOTIFY() __sev()
+#endif
+#endif
+
+typedef struct {
+    // Consumer side
+    _Alignas(SPSC_CACHE_LINE) _Atomic uint32_t head;   // next record to read (free-running)
+    uint32_t tail_cache;                                // consumer's last view of tail
+    // Producer side
+    _Alignas(SPSC_CACHE_LINE) _Atomic uint32_t tail;   // next record to write (free-running)
+    uint32_t head_cache;                                // producer's last view of head
+    // Read-only after spsc_ring_init()
+    _Alignas(SPSC_CACHE_LINE) uint8_t* buffer;
+    uint32_t record_size;
+    uint32_t capacity;                                  // records, power of two
+} spsc_ring_t;
+
+// storage must hold capacity * record_size bytes; capacity must be a power of two
+static inline bool spsc_ring_init(spsc_ring_t* r, void* storage, uint32_t record_size, uint32_t capacity)
+{
+    if (storage == NULL || record_size == 0 || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        return false;
+    }
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    r->tail_cache = 0;
+    r->head_cache = 0;
+    r->buffer = (uint8_t*)storage;
+    r->record_size = record_size;
+    r->capacity = capacity;
+    return true;
+}
+
+static inline uint8_t* spsc_ring_slot(const spsc_ring_t* r, uint32_t index)
+{
+    return r->buffer + (size_t)(index & (r->capacity - 1)) * r->record_size;
+}
+
+// ---- Producer side ----
+
+// Free records, re-reading the consumer's index only when the cached view is not enough
+static inline uint32_t spsc_ring_space(spsc_ring_t* r, uint32_t wanted)
+{
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint32_t space = r->capacity - (tail - r->head_cache);
+    if (space < wanted) {
+        r->head_cache = atomic_load_explicit(&r->head, memory_order_acquire);
+        space = r->capacity - (tail - r->head_cache);
+    }
+    return space;
+}
+
+// Zero-copy write: returns a contiguous run of up to *count free records (fewer
+// at the end of the buffer or when nearly full) and sets *count to its length.
+// Fill them in place, then spsc_ring_commit(). NULL if the ring is full.
+static inline void* spsc_ring_reserve(spsc_ring_t* r, uint32_t* count)
+{
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint32_t n = spsc_ring_space(r, *count);
+    uint32_t to_end = r->capacity - (tail & (r->capacity - 1));
+    if (n > to_end) {
+        n = to_end;
+    }
+    if (n > *count) {
+        n = *count;
+    }
+    *count = n;
+    return n ? spsc_ring_slot(r, tail) : NULL;
+}
+
+// Publish n records written through spsc_ring_reserve()
+static inline void spsc_ring_commit(spsc_ring_t* r, uint32_t n)
+{
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    atomic_store_explicit(&r->tail, tail + n, memory_order_release);
+    SPSC_RING_NOTIFY();
+}
+
+// Copy in up to n records, published together; returns how many fit
+static inline uint32_t spsc_ring_push_n(spsc_ring_t* r, const void* records, uint32_t n)
+{
+    uint32_t space = spsc_ring_space(r, n);
+    if (n > space) {
+        n = space;
+    }
+    if (n == 0) {
+        return 0;
+    }
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint32_t to_end = r->capacity - (tail & (r->capacity - 1));
+    uint32_t first = n < to_end ? n : to_end;
+    const uint8_t* src = (const uint8_t*)records;
+    memcpy(spsc_ring_slot(r, tail), src, (size_t)first * r->record_size);
+    if (n > first) {
+        memcpy(r->buffer, src + (size_t)first * r->record_size, (size_t)(n - first) * r->record_size);
+    }
+    atomic_store_explicit(&r->tail, tail + n, memory_order_release);
+    SPSC_RING_NOTIFY();
+    return n;
+}
+
+static inline bool spsc_ring_push(spsc_ring_t* r, const void* record)
+{
+    return spsc_ring_push_n(r, record, 1) == 1;
+}
+
+// ---- Consumer side ----
+
+// Queued records, re-reading the producer's index only when the cached view is not enough
+static inline uint32_t spsc_ring_available(spsc_ring_t* r, uint32_t wanted)
+{
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    uint32_t avail = r->tail_cache - head;
+    if (avail < wanted) {
+        r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+        avail = r->tail_cache - head;
+    }
+    return avail;
+}
+
+// Zero-copy read: returns a contiguous run of up to *count queued records and
+// sets *count to its length. The records stay valid until spsc_ring_release().
+static inline const void* spsc_ring_peek(spsc_ring_t* r, uint32_t* count)
+{
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    uint32_t n = spsc_ring_available(r, *count);
+    uint32_t to_end = r->capacity - (head & (r->capacity - 1));
+    if (n > to_end) {
+        n = to_end;
+    }
+    if (n > *count) {
+        n = *count;
+    }
+    *count = n;
+    return n ? spsc_ring_slot(r, head) : NULL;
+}
+
+// Hand n records read through spsc_ring_peek() back to the producer
+static inline void spsc_ring_release(spsc_ring_t* r, uint32_t n)
+{
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    atomic_store_explicit(&r->head, head + n, memory_order_release);
+}
+
+// Copy out up to max records; returns how many were read
+static inline uint32_t spsc_ring_pop_n(spsc_ring_t* r, void* records, uint32_t max)
+{
+    uint32_t n = spsc_ring_available(r, max);
+    if (n > max) {
+        n = max;
+    }
+    if (n == 0) {
+        return 0;
+    }
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    uint32_t to_end = r->capacity - (head & (r->capacity - 1));
+    uint32_t first = n < to_end ? n : to_end;
+    uint8_t* dst = (uint8_t*)records;
+    memcpy(dst, spsc_ring_slot(r, head), (size_t)first * r->record_size);
+    if (n > first) {
+        memcpy(dst + (size_t)first * r->record_size, r->buffer, (size_t)(n - first) * r->record_size);
+    }
+    atomic_store_explicit(&r->head, head + n, memory_order_release);
+    return n;
+}
+
+static inline bool spsc_ring_pop(spsc_ring_t* r, void* record)
+{
+    return spsc_ring_pop_n(r, record, 1) == 1;
+}
+
+// ---- Either side ----
+
+// Snapshot of the queued record count; exact only from the consumer
+static inline uint32_t spsc_ring_count(spsc_ring_t* r)
+{
+    return atomic_load_explicit(&r->tail, memory_order_acquire) - atomic_load_explicit(&r->head, memory_order_acquire);
+}
+
+static inline bool spsc_ring_empty(spsc_ring_t* r)
+{
+    return spsc_ring_count(r) == 0;
+}
+
+#endif
@@ -1,36 +1,552 @@
 #include <stdio.h>
+#include <string.h>
 #include "event_system.h"
 #include "pico/stdlib.h"
+#include "pico/critical_section.h"
+
+// Large enough and aligned for any payload (checked per topic below)
+typedef union {
+    sensor_event_t range;
+    signal_rate_event_t signal_rate;
+    error_event_t error;
+    actuator_event_t actuator;
+    void *block;            // block topics
+} event_payload_t;
 
 typedef struct {
-    event_callback_t callback;
+    topic_callback_t callback;
+    event_callback_t range_callback;    // event_subscribe() listener, range topic only
     void *context;
+    event_sub_options_t opts;
+    bool filtered;          // any option set; false takes the plain path
+    bool delivered;         // last_ms and last_value are valid
+    bool has_pending;       // pending holds a coalesced event (a block holds a reference)
+    uint32_t last_ms;       // time of the last delivery
+    uint32_t last_value;    // watched value at the last delivery
+    event_payload_t pending;
 } subscriber_entry_t;
 
-static subscriber_entry_t subscribers[MAX_LISTENERS];
-static int subscriber_count = 0;
+// Deferred dispatch ring of one topic. head and tail run free; the slot is
+// index & mask. The critical section covers both ends, since overwrite moves
+// the tail from the publisher's side.
+typedef struct {
+    uint8_t *buf;           // NULL: inline dispatch
+    uint32_t mask;
+    event_overflow_t overflow;
+    uint32_t head;          // next slot to write
+    uint32_t tail;          // next slot to read
+    critical_section_t lock;
+    event_queue_stats_t stats;
+} event_queue_t;
 
-bool event_subscribe(event_callback_t callback, void *context) {
-    if (subscriber_count < MAX_LISTENERS) {
-        subscribers[subscriber_count].callback = callback;
-        subscribers[subscriber_count].context = context; // Store the data pointer
-        subscriber_count++;
+typedef struct {
+#if MAX_LISTENERS > 0
+    subscriber_entry_t subscribers[MAX_LISTENERS];
+    uint32_t subscriber_count;
+#endif
+    event_queue_t queue;
+} topic_t;
+
+// Bounds of each topic's EVENT_LISTENER() section. The linker defines
+// __start_/__stop_ for a section named like a C identifier; a topic without
+// static listeners has no section, and the weak references stay NULL.
+#define LISTENER_SECTION(topic, size) \
+    extern const event_listener_t __start_event_listeners_##topic[] __attribute__((weak)); \
+    extern const event_listener_t __stop_event_listeners_##topic[] __attribute__((weak));
+#define LISTENER_BOUNDS(topic, size) \
+    [topic] = {__start_event_listeners_##topic, __stop_event_listeners_##topic},
+#define TOPIC_SIZE(topic, size) \
+    [topic] = (size),
+#define TOPIC_SIZE_FITS(topic, size) \
+    _Static_assert((size) <= sizeof(event_payload_t), #topic " payload does not fit event_payload_t");
+
+EVENT_TOPICS(LISTENER_SECTION)
+
+static const struct {
+    const event_listener_t *start;
+    const event_listener_t *stop;
+} static_listeners[] = {
+    EVENT_TOPICS(LISTENER_BOUNDS)
+};
+
+static const uint16_t topic_size[] = {
+    EVENT_TOPICS(TOPIC_SIZE)
+};
+
+_Static_assert(sizeof static_listeners / sizeof static_listeners[0] == TOPIC_COUNT,
+               "static_listeners[] needs one entry per topic");
+_Static_assert(sizeof topic_size / sizeof topic_size[0] == TOPIC_COUNT,
+               "topic_size[] needs one entry per topic");
+// Queues, coalescing and the lost-event copy hold payloads in an event_payload_t
+EVENT_TOPICS(TOPIC_SIZE_FITS)
+_Static_assert(sizeof(event_payload_t) <= UINT16_MAX, "topic_size[] holds payload sizes as uint16_t");
+
+#if EVENT_BLOCK_COUNT < 1 || EVENT_BLOCK_COUNT > 32
+#error "EVENT_BLOCK_COUNT must be 1..32"
+#endif
+
+// Payload block pool: a free bitmap and a reference count per block, all
+// under one critical section since blocks are allocated and released from
+// publishers (possibly ISRs) and from the dispatcher
+static uint8_t block_data[EVENT_BLOCK_COUNT][EVENT_BLOCK_SIZE] __attribute__((aligned(8)));
+static uint16_t block_refs[EVENT_BLOCK_COUNT];
+static uint32_t blocks_free = (uint32_t)(((uint64_t)1 << EVENT_BLOCK_COUNT) - 1);
+static event_pool_stats_t pool_stats = {EVENT_BLOCK_COUNT, 0, 0, 0};
+static critical_section_t pool_lock;
+static bool pool_ready = false;
+
+static topic_t topics[TOPIC_COUNT];
+static event_notify_t notify;
+static void *notify_arg;
+
+static bool topic_add_subscriber(event_topic_t topic, topic_callback_t callback,
+                                 event_callback_t range_callback, void *context,
+                                 const event_sub_options_t *opts) {
+#if MAX_LISTENERS > 0
+    if (topic >= TOPIC_COUNT) {
+        return false;
+    }
+    if (opts != NULL && opts->change_only &&
+        (topic_size[topic] != 0 ? opts->value_offset + sizeof(uint32_t) > topic_size[topic]
+                                : opts->value_offset + sizeof(uint32_t) > EVENT_BLOCK_SIZE)) {
+        return false;       // watched value outside the payload
+    }
+    topic_t *t = &topics[topic];
+    if (t->subscriber_count < MAX_LISTENERS) {
+        subscriber_entry_t *s = &t->subscribers[t->subscriber_count];
+        *s = (subscriber_entry_t){0};
+        s->callback = callback;
+        s->range_callback = range_callback;
+        s->context = context; // Store the data pointer
+        if (opts != NULL) {
+            s->opts = *opts;
+            s->filtered = opts->min_interval_ms != 0 || opts->coalesce || opts->change_only;
+        }
+        t->subscriber_count++;
         return true;
     }
+#else
+    (void)topic;
+    (void)callback;
+    (void)range_callback;
+    (void)context;
+    (void)opts;
+#endif
     return false;
 }
 
-// Publish an event to all listeners
+bool event_subscribe(event_callback_t callback, void *context) {
+    return topic_add_subscriber(TOPIC_RANGE, NULL, callback, context, NULL);
+}
+
+bool event_subscribe_opts(event_callback_t callback, void *context, const event_sub_options_t *opts) {
+    return topic_add_subscriber(TOPIC_RANGE, NULL, callback, context, opts);
+}
+
+bool event_topic_subscribe(event_topic_t topic, topic_callback_t callback, void *context) {
+    return topic_add_subscriber(topic, callback, NULL, context, NULL);
+}
+
+bool event_topic_subscribe_opts(event_topic_t topic, topic_callback_t callback, void *context,
+                                const event_sub_options_t *opts) {
+    return topic_add_subscriber(topic, callback, NULL, context, opts);
+}
+
+uint32_t event_topic_size(event_topic_t topic) {
+    return topic < TOPIC_COUNT ? topic_size[topic] : 0;
+}
+
+static inline bool topic_is_block(event_topic_t topic) {
+    return topic_size[topic] == 0;
+}
+
+// Bytes per queue slot: the payload, or the block pointer
+static inline uint32_t topic_slot_size(event_topic_t topic) {
+    return topic_is_block(topic) ? sizeof(void *) : topic_size[topic];
+}
+
+// Block index, or -1 for a pointer that is not the start of a pool block
+static int block_index(const void *block) {
+    const uint8_t *p = (const uint8_t *)block;
+    if (p < block_data[0] || p >= block_data[EVENT_BLOCK_COUNT]) {
+        return -1;
+    }
+    uint32_t offset = (uint32_t)(p - block_data[0]);
+    return offset % EVENT_BLOCK_SIZE == 0 ? (int)(offset / EVENT_BLOCK_SIZE) : -1;
+}
+
+void *event_block_alloc(void) {
+    if (!pool_ready) {
+        critical_section_init(&pool_lock);  // first call from thread context, before any ISR use
+        pool_ready = true;
+    }
+    critical_section_enter_blocking(&pool_lock);
+    if (blocks_free == 0) {
+        pool_stats.alloc_failed++;
+        critical_section_exit(&pool_lock);
+        return NULL;
+    }
+    int i = __builtin_ctz(blocks_free);
+    blocks_free &= blocks_free - 1;
+    block_refs[i] = 1;
+    pool_stats.in_use++;
+    if (pool_stats.in_use > pool_stats.high_water) {
+        pool_stats.high_water = pool_stats.in_use;
+    }
+    critical_section_exit(&pool_lock);
+    memset(block_data[i], 0, EVENT_BLOCK_SIZE);
+    return block_data[i];
+}
+
+void event_block_retain(const void *block) {
+    int i = block_index(block);
+    if (i < 0 || !pool_ready) {
+        return;
+    }
+    critical_section_enter_blocking(&pool_lock);
+    if (block_refs[i] != 0) {
+        block_refs[i]++;
+    }
+    critical_section_exit(&pool_lock);
+}
+
+void event_block_release(const void *block) {
+    int i = block_index(block);
+    if (i < 0 || !pool_ready) {
+        return;
+    }
+    critical_section_enter_blocking(&pool_lock);
+    if (block_refs[i] != 0 && --block_refs[i] == 0) {
+        blocks_free |= 1u << i;
+        pool_stats.in_use--;
+    }
+    critical_section_exit(&pool_lock);
+}
+
+void event_pool_stats(event_pool_stats_t *stats) {
+    if (!pool_ready) {
+        *stats = pool_stats;
+        return;
+    }
+    critical_section_enter_blocking(&pool_lock);
+    *stats = pool_stats;
+    critical_section_exit(&pool_lock);
+}
+
+#if MAX_LISTENERS > 0
+static void subscriber_call(const subscriber_entry_t *s, const void *payload) {
+    if (s->range_callback != NULL) {
+        s->range_callback(payload, s->context);
+    } else if (s->callback != NULL) {
+        s->callback(payload, s->context);
+    }
+}
+
+static inline uint32_t watched_value(const subscriber_entry_t *s, const void *payload) {
+    uint32_t value;
+    memcpy(&value, (const uint8_t *)payload + s->opts.value_offset, sizeof(value));
+    return value;
+}
+
+static inline bool subscriber_due(const subscriber_entry_t *s, uint32_t now) {
+    return !s->delivered || s->opts.min_interval_ms == 0 || now - s->last_ms >= s->opts.min_interval_ms;
+}
+
+static void pending_drop(subscriber_entry_t *s, bool block) {
+    if (s->has_pending && block) {
+        event_block_release(s->pending.block);
+    }
+    s->has_pending = false;
+}
+
+static void subscriber_deliver(subscriber_entry_t *s, const void *payload, uint32_t now) {
+    s->delivered = true;
+    s->last_ms = now;
+    if (s->opts.change_only) {
+        s->last_value = watched_value(s, payload);
+    }
+    subscriber_call(s, payload);
+}
+
+// One event for a filtered subscriber: deliver it, hold it as the newest
+// pending value, or skip it. batch: more events of this dispatch may follow.
+static void subscriber_offer(subscriber_entry_t *s, bool block, const void *payload, uint32_t size,
+                             uint32_t now, bool batch) {
+    if (s->opts.change_only && s->delivered) {
+        uint32_t value = watched_value(s, payload);
+        uint32_t change = value > s->last_value ? value - s->last_value : s->last_value - value;
+        if (change <= s->opts.deadband) {
+            pending_drop(s, block);     // the newest value is no change, an older pending one is stale
+            return;
+        }
+    }
+    bool due = subscriber_due(s, now);
+    if (s->opts.coalesce && (batch || !due)) {
+        pending_drop(s, block);
+        if (block) {
+            event_block_retain(payload);
+            s->pending.block = (void *)payload;
+        } else {
+            memcpy(&s->pending, payload, size);
+        }
+        s->has_pending = true;
+        return;
+    }
+    if (due) {
+        pending_drop(s, block);         // older than this event
+        subscriber_deliver(s, payload, now);
+    }
+}
+
+// Deliver the held-back values whose interval has passed
+static void subscribers_flush(topic_t *t, bool block, uint32_t now) {
+    for (uint32_t i = 0; i < t->subscriber_count; i++) {
+        subscriber_entry_t *s = &t->subscribers[i];
+        if (!s->has_pending || !subscriber_due(s, now)) {
+            continue;
+        }
+        s->has_pending = false;
+        if (block) {
+            subscriber_deliver(s, s->pending.block, now);
+            event_block_release(s->pending.block);
+        } else {
+            event_payload_t payload = s->pending;
+            subscriber_deliver(s, &payload, now);
+        }
+    }
+}
+#endif
+
+static void event_deliver(topic_t *t, const void *payload, bool batch) {
+    // Static listeners straight from flash
+    event_topic_t topic = (event_topic_t)(t - topics);
+    const event_listener_t *l = static_listeners[topic].start;
+    const event_listener_t *end = static_listeners[topic].stop;
+    for (; l != NULL && l < end; l++) {
+        l->callback(payload, l->context);
+    }
+#if MAX_LISTENERS > 0
+    uint32_t now = 0;
+    bool have_now = false;  // read the clock only for filtered subscribers
+    for (uint32_t i = 0; i < t->subscriber_count; i++) {
+        subscriber_entry_t *s = &t->subscribers[i];
+        if (!s->filtered) {
+            subscriber_call(s, payload);
+            continue;
+        }
+        if (!have_now) {
+            now = to_ms_since_boot(get_absolute_time());
+            have_now = true;
+        }
+        subscriber_offer(s, topic_is_block(topic), payload, topic_size[topic], now, batch);
+    }
+#else
+    (void)batch;
+#endif
+}
+
+// Copy one slot into the topic's ring. On overflow the lost slot (the new one
+// or the overwritten oldest) is copied to lost and false is returned.
+static bool topic_enqueue(event_queue_t *q, const void *slot, uint32_t size, event_payload_t *lost) {
+    bool queued = true;
+    critical_section_enter_blocking(&q->lock);
+    q->stats.published++;
+    uint32_t used = q->head - q->tail;
+    if (used > q->mask) {
+        q->stats.dropped++;
+        queued = false;
+        if (q->overflow == EVENT_DROP_NEWEST) {
+            memcpy(lost, slot, size);
+            critical_section_exit(&q->lock);
+            return false;
+        }
+        memcpy(lost, q->buf + (q->tail & q->mask) * size, size);
+        q->tail++;
+        used--;
+    }
+    memcpy(q->buf + (q->head & q->mask) * size, slot, size);
+    q->head++;
+    if (used + 1 > q->stats.high_water) {
+        q->stats.high_water = used + 1;
+    }
+    critical_section_exit(&q->lock);
+
+    if (notify != NULL) {
+        notify(notify_arg);
+    }
+    return queued;
+}
+
+// Publish to the topic's listeners, or queue the payload for event_dispatch()
+bool event_topic_publish(event_topic_t topic, const void *payload, uint32_t size) {
+    if (topic >= TOPIC_COUNT || topic_is_block(topic) || size != topic_size[topic]) {
+        return false;
+    }
+    topic_t *t = &topics[topic];
+    if (t->queue.buf == NULL) {
+        event_deliver(t, payload, false);
+        return true;
+    }
+    event_payload_t lost;
+    return topic_enqueue(&t->queue, payload, size, &lost);
+}
+
+// Hand a filled block to the topic: the listeners all see the block itself,
+// and the publisher's reference moves to the queue (or is dropped after an
+// inline delivery)
+bool event_block_publish(event_topic_t topic, void *block) {
+    if (topic >= TOPIC_COUNT || !topic_is_block(topic) || block_index(block) < 0) {
+        event_block_release(block);
+        return false;
+    }
+    topic_t *t = &topics[topic];
+    if (t->queue.buf == NULL) {
+        event_deliver(t, block, false);
+        event_block_release(block);
+        return true;
+    }
+    event_payload_t lost;
+    if (!topic_enqueue(&t->queue, &block, sizeof(void *), &lost)) {
+        event_block_release(lost.block);
+        return false;
+    }
+    return true;
+}
+
+// Publish a range event to all range listeners
 void event_publish(uint32_t distance) {
     // Create the event object
     sensor_event_t event;
     event.distance_cm = distance;
     event.timestamp = to_ms_since_boot(get_absolute_time());
+    EVENT_PUBLISH(TOPIC_RANGE, &event);
+}
+
+bool event_queue_init(event_topic_t topic, void *buf, uint32_t depth, event_overflow_t overflow) {
+    if (topic >= TOPIC_COUNT || buf == NULL || depth == 0 || (depth & (depth - 1)) != 0) {
+        return false;
+    }
+    event_queue_t *q = &topics[topic].queue;
+    if (q->buf == NULL) {
+        // Nothing queues yet, so the lock is set up once and buf goes last
+        critical_section_init(&q->lock);
+        q->mask = depth - 1;
+        q->overflow = overflow;
+        q->head = 0;
+        q->tail = 0;
+        q->stats = (event_queue_stats_t){0};
+        q->buf = buf;       // last: publishing starts queueing here
+        return true;
+    }
 
-    // Iterate and notify
-    for (int i = 0; i < subscriber_count; i++) {
-        if (subscribers[i].callback != NULL) {
-            subscribers[i].callback(&event, subscribers[i].context);
+    // Live queue: an ISR or the other core may be publishing, so the ring is
+    // swapped under its lock. Queued events are dropped; the references of
+    // queued blocks are released once the old ring is private.
+    critical_section_enter_blocking(&q->lock);
+    uint8_t *old_buf = q->buf;
+    uint32_t old_mask = q->mask;
+    uint32_t old_head = q->head;
+    uint32_t old_tail = q->tail;
+    q->buf = buf;
+    q->mask = depth - 1;
+    q->overflow = overflow;
+    q->head = 0;
+    q->tail = 0;
+    q->stats = (event_queue_stats_t){0};
+    critical_section_exit(&q->lock);
+    if (topic_is_block(topic)) {
+        for (uint32_t i = old_tail; i != old_head; i++) {
+            void *block;
+            memcpy(&block, old_buf + (i & old_mask) * sizeof(void *), sizeof(void *));
+            event_block_release(block);
         }
     }
+    return true;
+}
+
+void event_queue_notify(event_notify_t callback, void *arg) {
+    notify_arg = arg;
+    notify = callback;
+}
+
+// Drain one topic's queue in one batch. Listeners run outside the critical
+// section, so a publisher is never held up by a slow listener.
+uint32_t event_dispatch_topic(event_topic_t topic, uint32_t max_events) {
+    if (topic >= TOPIC_COUNT) {
+        return 0;
+    }
+    topic_t *t = &topics[topic];
+    if (t->queue.buf == NULL) {
+#if MAX_LISTENERS > 0
+        subscribers_flush(t, topic_is_block(topic), to_ms_since_boot(get_absolute_time()));
+#endif
+        return 0;
+    }
+    event_queue_t *q = &t->queue;
+    uint32_t size = topic_slot_size(topic);
+    bool block = topic_is_block(topic);
+
+    critical_section_enter_blocking(&q->lock);
+    uint32_t n = q->head - q->tail;
+    critical_section_exit(&q->lock);
+    if (max_events != 0 && n > max_events) {
+        n = max_events;
+    }
+
+    uint32_t delivered = 0;
+    while (delivered < n) {
+        event_payload_t payload;
+        critical_section_enter_blocking(&q->lock);
+        if (q->tail == q->head) {
+            critical_section_exit(&q->lock);
+            break;          // events were overwritten since the count was taken
+        }
+        memcpy(&payload, q->buf + (q->tail & q->mask) * size, size);
+        q->tail++;
+        q->stats.dispatched++;
+        critical_section_exit(&q->lock);
+
+        if (block) {
+            event_deliver(t, payload.block, true);
+            event_block_release(payload.block);    // the queue's reference
+        } else {
+            event_deliver(t, &payload, true);
+        }
+        delivered++;
+    }
+#if MAX_LISTENERS > 0
+    // Coalescing subscribers get the newest event of the batch here
+    subscribers_flush(t, block, to_ms_since_boot(get_absolute_time()));
+#endif
+    return delivered;
+}
+
+uint32_t event_dispatch(uint32_t max_events) {
+    uint32_t delivered = 0;
+    for (int topic = 0; topic < TOPIC_COUNT; topic++) {
+        delivered += event_dispatch_topic((event_topic_t)topic, max_events);
+    }
+    return delivered;
+}
+
+uint32_t event_queue_pending(event_topic_t topic) {
+    if (topic >= TOPIC_COUNT || topics[topic].queue.buf == NULL) {
+        return 0;
+    }
+    event_queue_t *q = &topics[topic].queue;
+    critical_section_enter_blocking(&q->lock);
+    uint32_t n = q->head - q->tail;
+    critical_section_exit(&q->lock);
+    return n;
+}
+
+void event_queue_stats(event_topic_t topic, event_queue_stats_t *stats) {
+    if (topic >= TOPIC_COUNT || topics[topic].queue.buf == NULL) {
+        *stats = (event_queue_stats_t){0};
+        return;
+    }
+    event_queue_t *q = &topics[topic].queue;
+    critical_section_enter_blocking(&q->lock);
+    *stats = q->stats;
+    critical_section_exit(&q->lock);
 }
@@ -4,21 +4,180 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-// 1. Define the data payload
+// 1. Define the topics and their data payloads
+// Each topic has its own payload type and its own subscriber list, so a
+// publish only reaches the listeners of that topic. One line per topic,
+// X(name, payload size); the enum, the payload size table and the static
+// listener sections are all generated from this list. TOPIC_RANGE_DATA is a
+// block topic (size 0): a pool block, e.g. VL53L0X_RangingMeasurementData_t,
+// published with event_block_publish().
+#define EVENT_TOPICS(X) \
+    X(TOPIC_RANGE,          sizeof(sensor_event_t)) \
+    X(TOPIC_SIGNAL_RATE,    sizeof(signal_rate_event_t)) \
+    X(TOPIC_ERROR,          sizeof(error_event_t)) \
+    X(TOPIC_ACTUATOR,       sizeof(actuator_event_t)) \
+    X(TOPIC_RANGE_DATA,     0)
+
+#define EVENT_TOPIC_ENUM(topic, size) topic,
+typedef enum {
+    EVENT_TOPICS(EVENT_TOPIC_ENUM)
+    TOPIC_COUNT
+} event_topic_t;
+
 typedef struct {
     uint32_t timestamp;
     uint32_t distance_cm;
 } sensor_event_t;
 
+typedef struct {
+    uint32_t timestamp;
+    uint32_t signal_rate;   // return signal rate, MCPS as 16.16 fixed point
+    uint32_t ambient_rate;  // ambient rate, MCPS as 16.16 fixed point
+} signal_rate_event_t;
+
+typedef struct {
+    uint32_t timestamp;
+    int32_t code;           // driver status, e.g. VL53L0X_Error
+    uint32_t source;        // publisher-defined, e.g. the I2C address
+} error_event_t;
+
+typedef enum {
+    ACTUATOR_OFF,
+    ACTUATOR_ON,
+    ACTUATOR_BLINK,
+} actuator_state_t;
+
+typedef struct {
+    uint32_t timestamp;
+    uint8_t id;             // e.g. the LED pin
+    uint8_t state;          // actuator_state_t
+    uint16_t period_ms;     // ACTUATOR_BLINK only
+} actuator_event_t;
+
 // 2. Define the callback function signature
 // Listeners must implement a function that looks like this
 typedef void (*event_callback_t)(const sensor_event_t *event, void *context);
+// Topic listeners get the topic's payload type behind the pointer
+typedef void (*topic_callback_t)(const void *payload, void *context);
+
+// Static listeners, fixed at build time: each EVENT_LISTENER() is a const
+// descriptor in the topic's own linker section (event_listeners_<topic>), and
+// publishing walks that section in flash. No RAM, no startup registration and
+// no limit on their number. topic must be the enum name itself:
+//
+//   static void on_range(const void *payload, void *context) { ... }
+//   EVENT_LISTENER(range_led, TOPIC_RANGE, on_range, &led_ctx);
+typedef struct {
+    topic_callback_t callback;
+    void *context;
+} event_listener_t;
 
-// System limits (static allocation is safer for embedded)
+#define EVENT_LISTENER(name, topic, callback, context) \
+    static const event_listener_t name \
+    __attribute__((used, section("event_listeners_" #topic), aligned(sizeof(void *)))) = {(callback), (context)}
+
+// Runtime listeners (event_subscribe(), event_topic_subscribe()), called after
+// the static ones. System limits (static allocation is safer for embedded);
+// per topic, 0 leaves only the static listeners and no subscriber RAM.
+#ifndef MAX_LISTENERS
 #define MAX_LISTENERS 4
+#endif
+
+// Per-subscriber delivery options (runtime listeners only). Filters apply in
+// this order: change-only, then the rate limit, then coalescing. A held-back
+// coalesced event is delivered by a later publish or by event_dispatch()
+// once its interval has passed, so call event_dispatch() from the loop even
+// without queues. All zero: every event, as with event_subscribe().
+typedef struct {
+    uint32_t min_interval_ms;   // at most one delivery per interval, 0 = no limit
+    bool coalesce;              // last value wins: hold the newest skipped event (or the
+                                // newest of a dispatch batch) instead of dropping it
+    bool change_only;           // deliver only when the watched value moved by more than deadband
+    uint16_t value_offset;      // change_only: offsetof() the watched uint32_t in the payload
+    uint32_t deadband;          // change_only: changes of up to this much are ignored
+} event_sub_options_t;
+
+// 3. Deferred dispatch (optional, per topic)
+// Without a queue, publishing calls every listener of the topic inline on the
+// publisher's stack. After event_queue_init() for a topic it only copies the
+// payload into that topic's bounded ring (constant cost, safe from an ISR or
+// the other core), and event_dispatch() delivers the queued events from a
+// task or the main loop.
+typedef enum {
+    EVENT_DROP_NEWEST,      // Full queue: the new event is lost
+    EVENT_OVERWRITE_OLDEST, // Full queue: the oldest queued event is lost
+} event_overflow_t;
+
+typedef struct {
+    uint32_t published;     // events handed to the queue
+    uint32_t dispatched;    // events delivered by event_dispatch()
+    uint32_t dropped;       // events lost to a full queue (either policy)
+    uint32_t high_water;    // deepest the queue has been
+} event_queue_stats_t;
+
+// Called after each queued event, e.g. to signal the dispatcher task.
+// Runs in the publisher's context (possibly an ISR).
+typedef void (*event_notify_t)(void *arg);
+
+// 4. Zero-copy payloads (block topics)
+// Larger payloads live in a fixed pool of EVENT_BLOCK_COUNT blocks of
+// EVENT_BLOCK_SIZE bytes, no heap. The publisher fills a block in place and
+// hands it to the bus; every listener gets the same block, and a listener
+// that needs it after its callback returns takes a reference with
+// event_block_retain(). The block goes back to the pool after the last
+// release. A block topic's queue holds block pointers, one reference each.
+#ifndef EVENT_BLOCK_SIZE
+#define EVENT_BLOCK_SIZE (64)
+#endif
+#ifndef EVENT_BLOCK_COUNT
+#define EVENT_BLOCK_COUNT (8)   // up to 32
+#endif
+
+typedef struct {
+    uint32_t blocks;        // EVENT_BLOCK_COUNT
+    uint32_t in_use;        // blocks currently allocated or referenced
+    uint32_t high_water;    // most blocks in use at once
+    uint32_t alloc_failed;  // event_block_alloc() calls that found the pool empty
+} event_pool_stats_t;
 
 // Public API
+// Range topic with its typed listener, as before topics existed
 bool event_subscribe(event_callback_t callback, void *context);
+bool event_subscribe_opts(event_callback_t callback, void *context, const event_sub_options_t *opts);
 void event_publish(uint32_t distance);
 
-#endif
\ No newline at end of file
+// Any topic. size must be the topic's payload size, so a payload of the wrong
+// type is refused (false) instead of being delivered; EVENT_PUBLISH() fills it in.
+// On a queued topic false also means a full queue lost an event: this one
+// (EVENT_DROP_NEWEST) or the oldest queued one (EVENT_OVERWRITE_OLDEST).
+bool event_topic_subscribe(event_topic_t topic, topic_callback_t callback, void *context);
+bool event_topic_subscribe_opts(event_topic_t topic, topic_callback_t callback, void *context,
+                                const event_sub_options_t *opts);
+bool event_topic_publish(event_topic_t topic, const void *payload, uint32_t size);
+#define EVENT_PUBLISH(topic, payload) event_topic_publish((topic), (payload), sizeof(*(payload)))
+uint32_t event_topic_size(event_topic_t topic);     // 0 for a block topic
+
+// Block topics. event_block_alloc() returns a zeroed block holding one
+// reference (NULL when the pool is empty); event_block_publish() takes that
+// reference over, also when it returns false (not a block topic, not a block,
+// or a full queue lost a block as with event_topic_publish()).
+void *event_block_alloc(void);
+bool event_block_publish(event_topic_t topic, void *block);
+void event_block_retain(const void *block);
+void event_block_release(const void *block);
+void event_pool_stats(event_pool_stats_t *stats);
+
+// buf holds depth payloads of the topic (void * for a block topic), depth a
+// power of two; false (and inline dispatch) for any other depth. Calling it
+// again on a live queue switches to the new buffer: events still queued are
+// dropped (their blocks released) and the statistics start over.
+bool event_queue_init(event_topic_t topic, void *buf, uint32_t depth, event_overflow_t overflow);
+void event_queue_notify(event_notify_t notify, void *arg);
+// Delivers up to max_events queued events per topic (0 = all queued before the
+// call), topics in enum order; returns the number delivered
+uint32_t event_dispatch(uint32_t max_events);
+uint32_t event_dispatch_topic(event_topic_t topic, uint32_t max_events);
+uint32_t event_queue_pending(event_topic_t topic);
+void event_queue_stats(event_topic_t topic, event_queue_stats_t *stats);
+
+#endif
@@ -5,6 +5,10 @@
 #include "vl53l0x_api.h"
 #include "vl53l0x_platform.h"
 #include "vl53l0x_i2c_platform.h"
+#include "async_task.h"
+#include "async_coro.h"
+#include "spsc_ring.h"
+#include "led_lib.h"
 
 // Details of time-of-flight ranging sensor VL53L0X and its API are from https://www.st.com/en/imaging-and-photonics-solutions/vl53l0x.html
 // Details of carrier/breakout board from Pololu: https://www.pololu.com/product/2490
@@ -86,46 +90,148 @@ VL53L0X_Error WaitMeasurementDataReady(VL53L0X_DEV Dev) {
 }
 #endif
 
+#ifdef TOF_INT_PIN
+// VL53L0X GPIO1 (new sample ready, active low) wired to TOF_INT_PIN: the range
+// task is signaled from the interrupt instead of polling the sensor over I2C
+static Task *tof_int_task;
+
+static void tof_int_callback(uint gpio, uint32_t events)
+{
+    (void)gpio;
+    (void)events;
+    task_signal(tof_int_task);
+}
+#endif
+
+// VL53L0X bring-up (DataInit, StaticInit, calibration, SPAD management) as a
+// coroutine. Each step runs on its own pass, so other tasks keep running
+// between the steps instead of the loop blocking for the whole sequence.
+typedef struct {
+    VL53L0X_Dev_t *dev;
+    Task *range;            // stopped (no callback) until ranging is running
+    uint32_t refSpadCount;
+    uint8_t isApertureSpads;
+    uint8_t VhvSettings;
+    uint8_t PhaseCal;
+} tof_bringup_t;
+
+static void range_task_callback(Task* task);
+
+static bool tof_data_ready(VL53L0X_Dev_t *dev)
+{
+    uint8_t ready = 0;
+    return VL53L0X_GetMeasurementDataReady(dev, &ready) == VL53L0X_ERROR_NONE && ready;
+}
+
+static void tof_bringup_callback(Task *task)
+{
+    tof_bringup_t *b = (tof_bringup_t *)task->user.ptr;
+    int rc;
+
+    CORO_BEGIN(task);
+    rc = VL53L0X_DataInit(b->dev);
+    hard_assert(rc == 0);
+    CORO_YIELD(task);
+
+    // Device initialization
+    rc = VL53L0X_StaticInit(b->dev);
+    hard_assert(rc == 0);
+    CORO_YIELD(task);
+
+    // Calibration
+    rc = VL53L0X_PerformRefCalibration(b->dev, &b->VhvSettings, &b->PhaseCal);
+    hard_assert(rc == 0);
+    CORO_YIELD(task);
+
+    rc = VL53L0X_PerformRefSpadManagement(b->dev, &b->refSpadCount, &b->isApertureSpads);
+    hard_assert(rc == 0);
+    CORO_YIELD(task);
+
+    rc = VL53L0X_SetDeviceMode(b->dev, VL53L0X_DEVICEMODE_CONTINUOUS_RANGING);
+    hard_assert(rc == 0);
+    rc = VL53L0X_StartMeasurement(b->dev);
+    hard_assert(rc == 0);
+
+    // First sample takes one timing budget (~33 ms)
+    await_ms(task, 30);
+    await_flag(task, tof_data_ready(b->dev));
+    printf("VL53L0X ranging (SPADs %u, VHV %u, phase %u)\n", b->refSpadCount, b->VhvSettings, b->PhaseCal);
+#ifdef TOF_INT_PIN
+    rc = VL53L0X_SetGpioConfig(b->dev, 0, VL53L0X_DEVICEMODE_CONTINUOUS_RANGING,
+                               VL53L0X_GPIOFUNCTIONALITY_NEW_MEASURE_READY, VL53L0X_INTERRUPTPOLARITY_LOW);
+    hard_assert(rc == 0);
+    tof_int_task = b->range;
+    task_wait_signal(b->range);
+    task_signal(b->range);  // the first sample is already waiting
+    gpio_init(TOF_INT_PIN);
+    gpio_pull_up(TOF_INT_PIN);
+    gpio_set_irq_enabled_with_callback(TOF_INT_PIN, GPIO_IRQ_EDGE_FALL, true, tof_int_callback);
+#endif
+    b->range->callback = range_task_callback;
+    CORO_END(task);
+}
+
+// How often the range task asks the sensor for a new sample when there is no
+// interrupt line (a sample takes one ~33 ms timing budget)
+#ifndef TOF_POLL_MS
+#define TOF_POLL_MS (5)
+#endif
+
 #define LED_RED     (7)
 #define LED_GREEN   (8)
 
+// LED tasks are pool tasks with the pin in user.data[0]; a stopped LED task
+// (no callback) holds its slot and keeps the LED steady
 static void led_blink_callback(Task* task) {
-    led_task_t *d = (led_task_t *)task;
-    led_flip(d->pin);
+    led_flip(task->user.data[0]);
 }
 
-static void init_led_task(led_task_t* led, uint32_t pin, uint32_t interval, TaskCallback callbk)
+static Task *led_task_add(uint pin)
 {
-    led->task.callback = callbk;
-    led->task.interval = interval;
-    led->pin = pin;
+    Task *led = task_add();
+    hard_assert(led != NULL);
+    led->user.data[0] = pin;
+    return led;
 }
 
-static inline void led_task_blink(led_task_t* led, uint32_t interval)
+static inline void led_task_blink(Task* led, uint32_t interval_ms)
 {
-   led->task.callback =  led_blink_callback;
-   led->task.interval = interval;
+   led->callback =  led_blink_callback;
+   led->interval = ASYNC_MS(interval_ms);
 }
 
-static inline void led_task_onoff(led_task_t* led, bool on)
+static inline void led_task_onoff(Task* led, bool on)
 {
-   led->task.callback =  NULL;
+   led->callback =  NULL;
    if (on)
-        led_on(led->pin);
+        led_on(led->user.data[0]);
     else
-        led_off(led->pin);
+        led_off(led->user.data[0]);
 }
 
-// Time-of-Flight range sensor task
+// One range reading handed from the sensor task to its consumers
+typedef struct {
+    uint32_t ms;            // time of the last valid reading
+    uint16_t range_mm;      // last valid range
+    bool valid;             // false: weak signal, range_mm/ms are from the last valid reading
+} range_sample_t;
+
+// Sensor readings go through a lock-free ring instead of shared fields, so the
+// acquisition side can move to a GPIO ISR or the other core unchanged
+#define RANGE_RING_SIZE (8)
+static range_sample_t range_ring_buf[RANGE_RING_SIZE];
+static spsc_ring_t range_ring;
+
+// Time-of-Flight range sensor task state (task->user.ptr)
 typedef struct {
-    Task task;
     VL53L0X_Dev_t *dev;
-    VL53L0X_RangingMeasurementData_t valid_data;
+    spsc_ring_t *out;
+    Task *consumer;         // signaled when a sample lands in out
     uint32_t start_ms;
     uint32_t last_valid_ms;
     uint16_t last_valid_measure;
     uint32_t latency;
-    bool valid;
+    uint32_t dropped;       // samples lost because the consumer fell behind
 } range_task_t;
 
 
@@ -134,7 +240,7 @@ static inline float mcps_from_fix1616(FixPoint1616_t v) {
 }
 
 static void range_task_callback(Task* task) {
-    range_task_t* rt = (range_task_t *)task;
+    range_task_t* rt = (range_task_t *)task->user.ptr;
     uint8_t new_data_ready=0;
     VL53L0X_Error status = VL53L0X_ERROR_NONE;
     VL53L0X_RangingMeasurementData_t data;
@@ -145,52 +251,59 @@ static void range_task_callback(Task* task) {
     }
     VL53L0X_GetRangingMeasurementData(rt->dev, &data);
     float mcps = mcps_from_fix1616(data.SignalRateRtnMegaCps);  // “Return signal rate (MCPS) … a 16.16 fix point value, which is effectively a measure of target reflectance.”
+    range_sample_t sample;
     if (mcps < 1.0) {
         // weak reflectance - no obstacle close enough
-        rt->valid=false;
+        sample.valid = false;
     } else {
         uint32_t ms = millis();
         rt->latency = ms - rt->last_valid_ms;
         rt->last_valid_ms = ms;
         rt->last_valid_measure = data.RangeMilliMeter;
-        rt->valid = true;
-
+        sample.valid = true;
+    }
+    sample.ms = rt->last_valid_ms;
+    sample.range_mm = rt->last_valid_measure;
+    if (!spsc_ring_push(rt->out, &sample)) {
+        rt->dropped++;
     }
+    task_signal(rt->consumer);
     VL53L0X_ClearInterruptMask(rt->dev, VL53L0X_REG_SYSTEM_INTERRUPT_GPIO_NEW_SAMPLE_READY);
 
 }
 
+// Print task state (task->user.ptr)
 typedef struct
 {
-    Task task;
     uint32_t prev_range_time_stamp;
-    range_task_t *range;
+    const range_sample_t *latest;
     uint32_t secs;
 } print_task_t;
 
 
 static void printDistance_callback(Task* task) {
-    print_task_t* ps = (print_task_t *)task;
+    print_task_t* ps = (print_task_t *)task->user.ptr;
     ps->secs++;
-    if  (ps->range->last_valid_ms == ps->prev_range_time_stamp && !ps->range->valid)
+    if  (ps->latest->ms == ps->prev_range_time_stamp && !ps->latest->valid)
     {
         printf("[%d]. Weak signal\n", ps->secs);
         return;
     }
-    if (ps->prev_range_time_stamp != ps->range->last_valid_ms)
+    if (ps->prev_range_time_stamp != ps->latest->ms)
     {
-        printf("[%d ms], D=%d mm\n", ps->range->last_valid_ms, ps->range->last_valid_measure);
-        ps->prev_range_time_stamp = ps->range->last_valid_ms;
+        printf("[%d ms], D=%d mm\n", ps->latest->ms, ps->latest->range_mm);
+        ps->prev_range_time_stamp = ps->latest->ms;
     }
 }
 
+// Manager task state (task->user.ptr)
 typedef struct
 {
-    Task task;
-    led_task_t *red_led;
-    led_task_t *green_led;
+    Task *red_led;
+    Task *green_led;
     uint32_t previous_ts;
-    range_task_t *range;
+    spsc_ring_t *samples;
+    range_sample_t latest;  // newest sample, also shown by the print task
 } manager_task_t;
 
 static inline uint32_t range_to_interval_ms(uint32_t range_mm) {
@@ -204,11 +317,19 @@ static inline uint32_t range_to_interval_ms(uint32_t range_mm) {
 }
 
 static void manager_callback(Task* task) {
-    manager_task_t* mngr = (manager_task_t *)task;
+    manager_task_t* mngr = (manager_task_t *)task->user.ptr;
 
-    if (mngr->range->valid)
+    // Drain in batches; only the newest reading matters for the LEDs
+    range_sample_t batch[RANGE_RING_SIZE];
+    uint32_t n = spsc_ring_pop_n(mngr->samples, batch, RANGE_RING_SIZE);
+    if (n == 0) {
+        return;
+    }
+    mngr->latest = batch[n - 1];
+
+    if (mngr->latest.valid)
     {
-        uint32_t interval = range_to_interval_ms(mngr->range->last_valid_measure);
+        uint32_t interval = range_to_interval_ms(mngr->latest.range_mm);
         led_task_blink(mngr->red_led, interval);
         led_task_onoff(mngr->green_led, true);
     }
@@ -224,11 +345,8 @@ int main()
     int rc = 0;
     led_off(LED_GREEN);
     led_off(LED_RED);
-    Task *led_green_task  = task_add();
-    Task *led_red_task = task_add();
-
-    led_green_task->user.data[0] = LED_GREEN;
-    led_red_task->user.data[0] = LED_RED;
+    Task *led_green_task = led_task_add(LED_GREEN);
+    Task *led_red_task = led_task_add(LED_RED);
 
     VL53L0X_Dev_t *ptof = &tofDev;
     VL53L0X_Error tof_status = VL53L0X_ERROR_NONE;
@@ -265,28 +383,6 @@ int main()
     printf("DeviceInfo: Name=%s,Type=%s, ProductId=%s\n", di.Name, di.Type, di.ProductId);
     printf("ProductType=%d\n", di.ProductType);
 
-    rc = VL53L0X_DataInit(ptof);
-    hard_assert(rc == 0);
-
-    // Device initialization
-    rc = VL53L0X_StaticInit(ptof);
-    hard_assert(rc==0);
-
-    uint32_t refSpadCount;
-    uint8_t isApertureSpads;
-    uint8_t VhvSettings;
-    uint8_t PhaseCal;
-
-    // Calibration
-    rc = VL53L0X_PerformRefCalibration(ptof, &VhvSettings, &PhaseCal); // Device Initialization
-    hard_assert(rc==0);
-
-    rc = VL53L0X_PerformRefSpadManagement(ptof, &refSpadCount, &isApertureSpads);
-    hard_assert(rc==0);
-    rc = VL53L0X_SetDeviceMode(ptof, VL53L0X_DEVICEMODE_CONTINUOUS_RANGING); // Setup in single ranging mode
-    hard_assert(rc==0);
-    rc = VL53L0X_StartMeasurement(ptof);
-
 #if 0
     uint32_t no_of_measurements = 32;
     uint16_t* pResults = (uint16_t*)malloc(sizeof(uint16_t) * no_of_measurements);
@@ -309,36 +405,60 @@ int main()
     free(pResults);
 #endif
 
+    spsc_ring_init(&range_ring, range_ring_buf, sizeof(range_sample_t), RANGE_RING_SIZE);
+
+    // Every task is a pool task; its state lives in main(), which never returns.
+    // A task runs once it has a callback, so that is set last.
+    manager_task_t managerTask;
+    Task *manager_task = task_add();
     range_task_t rangeTask;
-    rangeTask.task.callback = range_task_callback;
-    rangeTask.task.interval = 0;
+    Task *range_task = task_add();
+    print_task_t printDistance;
+    Task *print_task = task_add();
+    hard_assert(manager_task && range_task && print_task);
+
     rangeTask.dev = ptof;
+    rangeTask.out = &range_ring;
+    rangeTask.consumer = manager_task;
+    rangeTask.dropped = 0;
     rangeTask.start_ms = millis();
     rangeTask.latency = 0;
     rangeTask.last_valid_ms = 0;
     rangeTask.last_valid_measure = 0;
-    TaskList_Add(&ActiveTasksList, (Task *)&rangeTask);
+    range_task->user.ptr = &rangeTask;
+    range_task->interval = ASYNC_MS(TOF_POLL_MS);
+    range_task->priority = 0;                       // sensor path first
+    range_task->rel_deadline = ASYNC_MS(2);
+    // No callback yet: the bring-up coroutine starts it
 
-    print_task_t printDistance;
-    printDistance.task.callback = printDistance_callback;
-    printDistance.task.interval = 1000;
-    printDistance.range = &rangeTask;
+    printDistance.latest = &managerTask.latest;
     printDistance.prev_range_time_stamp = 0;
     printDistance.secs = 0;
-    TaskList_Add(&ActiveTasksList, (Task *)&printDistance);
-
-    manager_task_t managerTask;
-    managerTask.range = &rangeTask;
-    managerTask.red_led = &led2;
-    managerTask.green_led = &led1;
-
-    managerTask.task.callback = manager_callback;
-    managerTask.task.interval = 0;
+    print_task->user.ptr = &printDistance;
+    print_task->interval = ASYNC_MS(1000);
+    print_task->priority = 3;                       // printf over UART can wait
+    print_task->callback = printDistance_callback;
+
+    managerTask.samples = &range_ring;
+    managerTask.latest = (range_sample_t){0};
+    managerTask.red_led = led_red_task;
+    managerTask.green_led = led_green_task;
     managerTask.previous_ts = 0;
-    TaskList_Add(&ActiveTasksList, (Task *)&managerTask);
-
-    while (true) {
-        Update(&ActiveTasksList);
-        sleep_ms(1);
-    }
+    manager_task->user.ptr = &managerTask;
+    manager_task->interval = 0;        // runs only when the range task signals a sample
+    manager_task->priority = 1;
+    task_wait_signal(manager_task);
+    manager_task->callback = manager_callback;
+
+    // Calibration runs as a coroutine next to the LED and print tasks; it starts
+    // the range task once the sensor is ranging
+    static tof_bringup_t bringup;
+    bringup.dev = ptof;
+    bringup.range = range_task;
+    Task *bringup_task = task_add();
+    bringup_task->user.ptr = &bringup;
+    bringup_task->callback = tof_bringup_callback;
+
+    // Sleeps until the next task is due instead of polling every 1 ms
+    scheduler_run();
 }
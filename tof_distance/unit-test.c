@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include "pico/stdlib.h"
 #include "event_system.h"
 
@@ -11,6 +12,18 @@ static inline uint32_t millis()
 #define LED_RED (7)
 #define LED_GREEN (8)
 
+// Sensor events are queued by event_publish() and delivered from the super loop
+#define EVENT_QUEUE_DEPTH (8)
+static sensor_event_t event_queue_buf[EVENT_QUEUE_DEPTH];
+
+// Full reading with its (simulated) histogram, published in place in a pool block
+typedef struct
+{
+    uint32_t timestamp;
+    uint32_t distance_cm;
+    uint16_t histogram[8];
+} range_record_t;
+
 typedef struct
 {
     uint32_t last_run_time;
@@ -18,6 +31,7 @@ typedef struct
     uint32_t pin;
     uint32_t last_valid_distance_cm;
     bool led_state; // Only used for the LED task
+    const range_record_t *record; // newest record, held with event_block_retain()
 } task_context_t;
 
 // --- Task 1: Blink LED ---
@@ -45,6 +59,29 @@ void task_serial_print(task_context_t *ctx)
     {
         ctx->last_run_time = current_time;
         printf("[%d] ms. Data received: %d cm\n", current_time, ctx->last_valid_distance_cm);
+
+        event_queue_stats_t stats;
+        event_queue_stats(TOPIC_RANGE, &stats);
+        printf("events: %d published, %d dispatched, %d dropped, high water %d\n",
+               stats.published, stats.dispatched, stats.dropped, stats.high_water);
+
+        event_pool_stats_t pool;
+        event_pool_stats(&pool);
+        if (ctx->record != NULL)
+        {
+            int peak = 0;
+            for (int i = 1; i < 8; i++)
+            {
+                if (ctx->record->histogram[i] > ctx->record->histogram[peak])
+                {
+                    peak = i;
+                }
+            }
+            printf("record: %d cm (bin %d), histogram peak %d in bin %d\n", ctx->record->distance_cm,
+                   ctx->record->distance_cm / 16, ctx->record->histogram[peak], peak);
+        }
+        printf("blocks: %d of %d in use, high water %d, %d failed\n",
+               pool.in_use, pool.blocks, pool.high_water, pool.alloc_failed);
     }
 }
 
@@ -61,6 +98,13 @@ static void on_sensor_data_led(const sensor_event_t *e, void *ctx)
     if (t->pin == LED_GREEN)
     {
         bool is_close = (e->distance_cm < 25) ? true : false;
+        if (t->led_state != !is_close)
+        {
+            // Only the actuator listeners hear about it, not the range listeners
+            actuator_event_t a = {e->timestamp, (uint8_t)t->pin, is_close ? ACTUATOR_OFF : ACTUATOR_ON, 0};
+            EVENT_PUBLISH(TOPIC_ACTUATOR, &a);
+        }
+        t->led_state = !is_close;
         gpio_put(t->pin, !is_close);
     }
     else
@@ -77,13 +121,35 @@ void on_sensor_data_log(const sensor_event_t *e, void *ctx)
     t->last_valid_distance_cm = e->distance_cm;
 }
 
-// Simulates a sensor reading every 1 second
+// Keeps the newest record block; the previous one goes back to the pool
+void on_range_record(const void *payload, void *ctx)
+{
+    task_context_t *t = (task_context_t *)ctx;
+    event_block_retain(payload);
+    if (t->record != NULL)
+    {
+        event_block_release(t->record);
+    }
+    t->record = (const range_record_t *)payload;
+}
+
+// --- Listener 3: Actuator log ---
+// Registered at build time: a const descriptor in flash, no event_subscribe() call
+static void on_actuator(const void *payload, void *ctx)
+{
+    const actuator_event_t *a = (const actuator_event_t *)payload;
+    (void)ctx;
+    printf("[%d] ms. LED %d %s\n", a->timestamp, a->id, a->state == ACTUATOR_ON ? "on" : "off");
+}
+EVENT_LISTENER(actuator_log, TOPIC_ACTUATOR, on_actuator, NULL);
+
+// Simulates a sensor reading at 50 Hz
 void simulate_sensor_reading()
 {
     static uint32_t last_read = 0;
     uint32_t now = to_ms_since_boot(get_absolute_time());
 
-    if (now - last_read > 1000)
+    if (now - last_read >= 20)
     {
         last_read = now;
 
@@ -92,6 +158,23 @@ void simulate_sensor_reading()
 
         // TRIGGER THE EVENT
         event_publish(fake_distance);
+
+        // The full record is filled in place and shared by its listeners, no copies
+        range_record_t *rec = event_block_alloc();
+        if (rec != NULL)
+        {
+            rec->timestamp = now;
+            rec->distance_cm = fake_distance;
+            // Returns spread around the distance's bin, 16 cm per bin, so the
+            // peak moves across all eight bins as the distance sweeps
+            int bin = fake_distance / 16;
+            for (int i = 0; i < 8; i++)
+            {
+                int d = i > bin ? i - bin : bin - i;
+                rec->histogram[i] = (uint16_t)(d < 4 ? 1000 >> (2 * d) : 0);
+            }
+            event_block_publish(TOPIC_RANGE_DATA, rec);
+        }
     }
 }
 
@@ -108,10 +191,19 @@ int main()
 
     task_context_t serial_log_task = {0, 1000, 0, false};
 
-    // 1. Subscribe listeners
-    event_subscribe(on_sensor_data_log, &serial_log_task);
-    event_subscribe(on_sensor_data_led, &led_red_task);
-    event_subscribe(on_sensor_data_led, &led_green_task);
+    // 1. Subscribe listeners; they run from event_dispatch(), not inside event_publish()
+    event_queue_init(TOPIC_RANGE, event_queue_buf, EVENT_QUEUE_DEPTH, EVENT_OVERWRITE_OLDEST);
+    // Each listener takes only what it needs from the 50 Hz stream: the logger
+    // the newest value twice a second, the blink rate at most 5 updates a
+    // second, the near/far LED only real changes
+    const event_sub_options_t log_opts = {.min_interval_ms = 500, .coalesce = true};
+    const event_sub_options_t blink_opts = {.min_interval_ms = 200, .coalesce = true};
+    const event_sub_options_t near_opts = {
+        .change_only = true, .value_offset = offsetof(sensor_event_t, distance_cm), .deadband = 2};
+    event_subscribe_opts(on_sensor_data_log, &serial_log_task, &log_opts);
+    event_subscribe_opts(on_sensor_data_led, &led_red_task, &blink_opts);
+    event_subscribe_opts(on_sensor_data_led, &led_green_task, &near_opts);
+    event_topic_subscribe(TOPIC_RANGE_DATA, on_range_record, &serial_log_task);
 
     printf("System started. Entering Super Loop...\n");
 
@@ -124,6 +216,7 @@ int main()
         task_serial_print(&serial_log_task);
 
         simulate_sensor_reading();
+        event_dispatch(0);
 
         // Optional: Minimal sleep to reduce power if high precision isn't needed
         sleep_us(1000);